@@ -0,0 +1,65 @@
+#include "analytics/affinity.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+bool pin_current_thread(int cpu) {
+  if (cpu < 0)
+    return true;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (err != 0) {
+    std::cerr << "[AFFINITY] cannot pin to cpu " << cpu << ": "
+              << std::strerror(err) << "\n";
+    return false;
+  }
+  return true;
+#else
+  std::cerr << "[AFFINITY] thread pinning not supported on this platform\n";
+  return false;
+#endif
+}
+
+int numa_node_of_cpu(int cpu) {
+  if (cpu < 0)
+    return -1;
+#ifdef __linux__
+  // /sys/devices/system/cpu/cpuN/ holds a `nodeK` link.
+  std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+  DIR *dir = ::opendir(path.c_str());
+  if (dir == nullptr)
+    return -1;
+  int node = -1;
+  while (dirent *entry = ::readdir(dir)) {
+    if (std::strncmp(entry->d_name, "node", 4) == 0 &&
+        entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+      node = std::atoi(entry->d_name + 4);
+      break;
+    }
+  }
+  ::closedir(dir);
+  return node;
+#else
+  return -1;
+#endif
+}
+
+std::string describe_cpu(int cpu) {
+  if (cpu < 0)
+    return "unpinned";
+  std::string text = "cpu " + std::to_string(cpu);
+  int node = numa_node_of_cpu(cpu);
+  if (node >= 0)
+    text += " (node " + std::to_string(node) + ")";
+  return text;
+}
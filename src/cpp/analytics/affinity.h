@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+
+// Thread placement (`[affinity]` in config.toml).
+//
+// Memory follows the thread by first touch: the kernel places a page on the
+// NUMA node of the CPU that first writes it, so state built by a thread
+// *after* it is pinned (a worker's ring, arena, per-source tables) lands on
+// that thread's node without libnuma.
+
+// Pins the calling thread to `cpu`; `cpu < 0` leaves it to the scheduler.
+// Prints the reason and returns false if the OS refuses or pinning is not
+// supported on this platform.
+bool pin_current_thread(int cpu);
+
+// NUMA node of `cpu` from sysfs, or -1 if unknown.
+int numa_node_of_cpu(int cpu);
+
+// "cpu 3 (node 0)", "cpu 3" or "unpinned", for startup logs.
+std::string describe_cpu(int cpu);
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Fixed-size arrays that start on a cache line, for hot tables and columns.
+
+constexpr size_t kCacheLine = 64;
+
+struct AlignedDelete {
+  void operator()(void *p) const {
+    ::operator delete[](p, std::align_val_t(kCacheLine));
+  }
+};
+
+template <typename T> using AlignedArray = std::unique_ptr<T[], AlignedDelete>;
+
+// `n` value-initialized elements. T must be trivially destructible.
+template <typename T> AlignedArray<T> make_aligned_array(size_t n) {
+  static_assert(std::is_trivially_destructible<T>::value,
+                "AlignedArray does not run destructors");
+  auto *p = static_cast<T *>(
+      ::operator new[](n * sizeof(T), std::align_val_t(kCacheLine)));
+  std::uninitialized_value_construct_n(p, n);
+  return AlignedArray<T>(p);
+}
+
+// `n` rounded up to whole cache lines of T.
+template <typename T> constexpr size_t round_up_to_line(size_t n) {
+  constexpr size_t per_line = kCacheLine / sizeof(T);
+  return (n + per_line - 1) / per_line * per_line;
+}
@@ -0,0 +1,39 @@
+// Global operator new/delete replacement for ENABLE_ALLOC_CHECK builds.
+// Only linked into the binary when that option is on.
+
+#include "analytics/alloc_check.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local uint64_t t_allocs = 0;
+} // namespace
+
+uint64_t thread_alloc_count() { return t_allocs; }
+
+void *operator new(std::size_t size) {
+  ++t_allocs;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+  ++t_allocs;
+  void *p = nullptr;
+  size_t alignment = static_cast<size_t>(align);
+  if (alignment < sizeof(void *))
+    alignment = sizeof(void *);
+  if (posix_memalign(&p, alignment, size ? size : 1) != 0)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
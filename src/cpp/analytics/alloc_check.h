@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+// ================= Allocation check =================
+//
+// Built with ENABLE_ALLOC_CHECK, alloc_check.cpp replaces the global
+// operator new/delete and counts allocations per thread. `RealAllocCheck`
+// brackets the hot path and aborts the process if steady state allocates.
+// Allocations libzmq makes internally with malloc are not visible here.
+
+struct NullAllocCheck {
+  // cppcheck-suppress functionStatic
+  inline void begin() {}
+  // cppcheck-suppress functionStatic
+  inline void end() {}
+};
+
+#ifdef ENABLE_ALLOC_CHECK
+
+uint64_t thread_alloc_count();
+
+struct RealAllocCheck {
+  // Frames allowed to allocate while pools and reader stacks warm up.
+  static constexpr uint64_t kWarmupFrames = 64;
+
+  uint64_t frames = 0;
+  uint64_t start = 0;
+
+  inline void begin() { start = thread_alloc_count(); }
+
+  inline void end() {
+    uint64_t allocs = thread_alloc_count() - start;
+    if (++frames > kWarmupFrames && allocs != 0) {
+      std::cerr << "[ALLOC] " << allocs
+                << " heap allocation(s) in steady-state hot path (frame "
+                << frames << ")\n";
+      std::abort();
+    }
+  }
+};
+
+using AllocCheck = RealAllocCheck;
+#else
+using AllocCheck = NullAllocCheck;
+#endif
@@ -0,0 +1,248 @@
+#include "analytics/capture.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "analytics/frame.h"
+
+namespace {
+
+inline size_t pad8(size_t n) { return (n + 7) & ~size_t{7}; }
+
+// Records, and the binary payloads' detections, are read in place.
+static_assert(alignof(CaptureRecord) <= 8 && alignof(Detection) <= 8,
+              "capture records are 8-byte aligned");
+
+inline size_t record_bytes(size_t topic_len, size_t payload_len) {
+  return sizeof(CaptureRecord) + pad8(topic_len) + pad8(payload_len);
+}
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+void report_errno(const char *what, const std::string &path) {
+  std::cerr << "[CAPTURE] " << what << " " << path << ": "
+            << std::strerror(errno) << "\n";
+}
+
+} // namespace
+
+// ================= CaptureWriter =================
+
+CaptureWriter::~CaptureWriter() { close(); }
+
+bool CaptureWriter::open(const std::string &path, size_t max_bytes,
+                         WireFormat format) {
+  close();
+
+  if (max_bytes < sizeof(CaptureFileHeader)) {
+    std::cerr << "[CAPTURE] capture.max_mb too small\n";
+    return false;
+  }
+
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    report_errno("cannot create", path);
+    return false;
+  }
+  if (::ftruncate(fd_, static_cast<off_t>(max_bytes)) != 0) {
+    report_errno("cannot size", path);
+    close();
+    return false;
+  }
+
+  void *p = ::mmap(nullptr, max_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   fd_, 0);
+  if (p == MAP_FAILED) {
+    report_errno("cannot map", path);
+    close();
+    return false;
+  }
+  base_ = static_cast<unsigned char *>(p);
+  mapped_ = max_bytes;
+
+  header_ = reinterpret_cast<CaptureFileHeader *>(base_);
+  header_->magic = kCaptureMagic;
+  header_->version = kCaptureVersion;
+  header_->header_size = sizeof(CaptureFileHeader);
+  header_->format = static_cast<uint32_t>(format);
+  header_->reserved = 0;
+  header_->data_bytes = 0;
+  header_->records = 0;
+  return true;
+}
+
+void CaptureWriter::append(const zmq::message_t &topic,
+                           const zmq::message_t &payload) {
+  size_t offset = sizeof(CaptureFileHeader) + header_->data_bytes;
+  size_t bytes = record_bytes(topic.size(), payload.size());
+  if (bytes > mapped_ - offset) {
+    skipped_++;
+    return;
+  }
+
+  unsigned char *p = base_ + offset;
+  CaptureRecord record{now_ns(), static_cast<uint32_t>(topic.size()),
+                       static_cast<uint32_t>(payload.size())};
+  std::memcpy(p, &record, sizeof(record));
+  p += sizeof(record);
+  std::memcpy(p, topic.data(), topic.size());
+  p += pad8(topic.size());
+  std::memcpy(p, payload.data(), payload.size());
+
+  // Commit only once the record is complete.
+  header_->data_bytes += bytes;
+  header_->records++;
+}
+
+void CaptureWriter::close() {
+  if (base_ != nullptr) {
+    size_t used = sizeof(CaptureFileHeader) + header_->data_bytes;
+    ::munmap(base_, mapped_);
+    if (::ftruncate(fd_, static_cast<off_t>(used)) != 0)
+      std::cerr << "[CAPTURE] cannot trim capture file\n";
+    base_ = nullptr;
+    header_ = nullptr;
+    mapped_ = 0;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+// ================= Replayer =================
+
+Replayer::Replayer(const ZmqConfig &zmq, const CaptureConfig &cfg)
+    : path_(cfg.path), speed_(cfg.speed), format_(zmq.format),
+      payloads_(static_cast<size_t>(zmq.batch_size > 0 ? zmq.batch_size : 1)) {
+}
+
+Replayer::~Replayer() {
+  // Payloads may still point into the mapping.
+  payloads_.clear();
+  if (base_ != nullptr)
+    ::munmap(const_cast<unsigned char *>(base_), mapped_);
+  if (fd_ >= 0)
+    ::close(fd_);
+}
+
+bool Replayer::open() {
+  fd_ = ::open(path_.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    report_errno("cannot open", path_);
+    return false;
+  }
+
+  struct stat st {};
+  if (::fstat(fd_, &st) != 0) {
+    report_errno("cannot stat", path_);
+    return false;
+  }
+  mapped_ = static_cast<size_t>(st.st_size);
+  if (mapped_ < sizeof(CaptureFileHeader)) {
+    std::cerr << "[CAPTURE] " << path_ << " is not a capture file\n";
+    return false;
+  }
+
+  void *p = ::mmap(nullptr, mapped_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (p == MAP_FAILED) {
+    report_errno("cannot map", path_);
+    return false;
+  }
+  base_ = static_cast<const unsigned char *>(p);
+  // Replay walks the file front to back.
+  ::madvise(p, mapped_, MADV_SEQUENTIAL);
+
+  CaptureFileHeader header;
+  std::memcpy(&header, base_, sizeof(header));
+  if (header.magic != kCaptureMagic || header.version != kCaptureVersion ||
+      header.header_size < sizeof(CaptureFileHeader) ||
+      header.header_size > mapped_ || header.header_size % 8 != 0 ||
+      header.format > static_cast<uint32_t>(WireFormat::kBinary)) {
+    std::cerr << "[CAPTURE] " << path_ << " is not a capture file\n";
+    return false;
+  }
+
+  format_ = static_cast<WireFormat>(header.format);
+  records_ = header.records;
+  offset_ = header.header_size;
+  // A truncated copy of a file replays up to its last whole record.
+  end_ = header.data_bytes > mapped_ - offset_ ? mapped_
+                                               : offset_ + header.data_bytes;
+  return true;
+}
+
+const CaptureRecord *Replayer::next_record() const {
+  if (end_ - offset_ < sizeof(CaptureRecord))
+    return nullptr;
+  const auto *record = reinterpret_cast<const CaptureRecord *>(base_ + offset_);
+  if (record_bytes(record->topic_len, record->payload_len) > end_ - offset_)
+    return nullptr;
+  return record;
+}
+
+std::chrono::steady_clock::time_point
+Replayer::due(const CaptureRecord &record) const {
+  auto offset = static_cast<double>(record.recv_ns - first_recv_ns_) / speed_;
+  return start_ + std::chrono::nanoseconds(static_cast<int64_t>(offset));
+}
+
+size_t Replayer::recv_batch() {
+  count_ = 0;
+
+  while (count_ < payloads_.size() &&
+         !stopping_.load(std::memory_order_relaxed)) {
+    const CaptureRecord *record = next_record();
+    if (record == nullptr)
+      break;
+
+    if (speed_ > 0.0) {
+      if (replayed_ == 0) {
+        first_recv_ns_ = record->recv_ns;
+        start_ = std::chrono::steady_clock::now();
+      }
+      // Only the first message of a batch waits; later ones join it if they
+      // are already due, like a drain of the socket queue.
+      auto due_at = due(*record);
+      if (count_ > 0 && std::chrono::steady_clock::now() < due_at)
+        break;
+      if (!wait_until(due_at))
+        break;
+    }
+
+    const unsigned char *payload = reinterpret_cast<const unsigned char *>(
+                                       record + 1) +
+                                   pad8(record->topic_len);
+    // No free function: the message borrows the mapping.
+    payloads_[count_].rebuild(const_cast<unsigned char *>(payload),
+                              record->payload_len, nullptr, nullptr);
+    count_++;
+    replayed_++;
+    offset_ += record_bytes(record->topic_len, record->payload_len);
+  }
+  return count_;
+}
+
+bool Replayer::wait_until(std::chrono::steady_clock::time_point t) const {
+  // Sliced, so a stop is seen within one slice even across a long gap.
+  constexpr auto kSlice = std::chrono::milliseconds(100);
+  while (!stopping_.load(std::memory_order_relaxed)) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= t)
+      return true;
+    std::this_thread::sleep_until(std::min(t, now + kSlice));
+  }
+  return false;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include <zmq.hpp>
+
+// ================= Capture file =================
+//
+// Append-only log of received `(topic, payload)` messages, written through a
+// shared memory mapping so recording is a memcpy per message.
+//
+//   CaptureFileHeader (32 bytes)
+//   record*                       each 8-byte aligned:
+//     CaptureRecord (16 bytes)    receive time, topic/payload lengths
+//     topic                       padded to 8
+//     payload                     padded to 8
+//
+// `data_bytes` in the header is advanced after each record is complete, so a
+// file from a killed recorder replays up to its last whole record. Host byte
+// order, like the binary wire format.
+
+struct CaptureFileHeader {
+  uint32_t magic;       // kCaptureMagic
+  uint16_t version;     // kCaptureVersion
+  uint16_t header_size; // bytes before the first record
+  uint32_t format;      // WireFormat of the payloads
+  uint32_t reserved;
+  uint64_t data_bytes; // committed record bytes after the header
+  uint64_t records;
+};
+
+struct CaptureRecord {
+  int64_t recv_ns; // system_clock, ns since the epoch
+  uint32_t topic_len;
+  uint32_t payload_len;
+};
+
+constexpr uint32_t kCaptureMagic = 0x50414359; // "YCAP" little-endian
+constexpr uint16_t kCaptureVersion = 1;
+
+static_assert(sizeof(CaptureFileHeader) == 32, "capture header changed");
+static_assert(sizeof(CaptureRecord) == 16, "capture record changed");
+
+// Records every message the receiver takes off the socket. Messages that no
+// longer fit in `max_mb` are not recorded (counted in `skipped`).
+class CaptureWriter {
+public:
+  CaptureWriter() = default;
+  ~CaptureWriter();
+
+  CaptureWriter(const CaptureWriter &) = delete;
+  CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+  // Creates (truncates) `path` and maps `max_bytes` of it. Prints the reason
+  // and returns false on failure.
+  bool open(const std::string &path, size_t max_bytes, WireFormat format);
+
+  void append(const zmq::message_t &topic, const zmq::message_t &payload);
+
+  // Trims the file to the records written and unmaps it.
+  void close();
+
+  uint64_t records() const { return header_ ? header_->records : 0; }
+  uint64_t skipped() const { return skipped_; }
+
+private:
+  int fd_ = -1;
+  unsigned char *base_ = nullptr;
+  size_t mapped_ = 0;
+  CaptureFileHeader *header_ = nullptr;
+  uint64_t skipped_ = 0;
+};
+
+// Feeds a capture file back through the same path as `Receiver`: batches of
+// `zmq::message_t` that point straight into the read-only mapping.
+//
+//   speed == 0   as fast as possible (no clock reads)
+//   speed == 1   original inter-arrival timing
+//   speed == N   N times faster than recorded
+class Replayer {
+public:
+  Replayer(const ZmqConfig &zmq, const CaptureConfig &cfg);
+  ~Replayer();
+
+  Replayer(const Replayer &) = delete;
+  Replayer &operator=(const Replayer &) = delete;
+
+  // Maps the file and validates its header. Prints the reason and returns
+  // false on failure.
+  bool open();
+
+  WireFormat format() const { return format_; }
+  uint64_t records() const { return records_; }
+
+  // Returns the number of payloads in the next batch; 0 at end of file or
+  // once stopped.
+  size_t recv_batch();
+
+  // Ends the replay early, cutting short a paced wait. Async-signal-safe,
+  // callable from any thread.
+  void stop() { stopping_.store(true, std::memory_order_relaxed); }
+
+  zmq::message_t *begin() { return payloads_.data(); }
+  zmq::message_t *end() { return payloads_.data() + count_; }
+  size_t size() const { return count_; }
+
+  // Payloads handed out so far.
+  uint64_t replayed() const { return replayed_; }
+
+private:
+  // Next record, or nullptr at end of file.
+  const CaptureRecord *next_record() const;
+
+  // When `record` is due under `speed`.
+  std::chrono::steady_clock::time_point due(const CaptureRecord &record) const;
+
+  // Sleeps until `t`, waking early to check for `stop`. False if stopped.
+  bool wait_until(std::chrono::steady_clock::time_point t) const;
+
+  std::string path_;
+  double speed_;
+  WireFormat format_;
+
+  int fd_ = -1;
+  const unsigned char *base_ = nullptr;
+  size_t mapped_ = 0;
+  size_t offset_ = 0; // next record
+  size_t end_ = 0;    // end of committed records
+  uint64_t records_ = 0;
+  uint64_t replayed_ = 0;
+
+  int64_t first_recv_ns_ = 0;
+  std::chrono::steady_clock::time_point start_;
+
+  std::vector<zmq::message_t> payloads_;
+  size_t count_ = 0;
+  std::atomic<bool> stopping_{false};
+};
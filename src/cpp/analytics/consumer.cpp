@@ -0,0 +1,324 @@
+#include "analytics/consumer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+namespace {
+
+// Most events one message can produce: per detection, a crossing per line
+// and a firing per rule of its source, an enter or exit and a loitering
+// alert per zone, and its track ending.
+size_t event_capacity(const Config &cfg) {
+  std::map<int, size_t> per_source; // events per detection beyond the one
+  for (const auto &wire : cfg.tripwires)
+    per_source[wire.source_id]++;
+  for (const auto &zone : cfg.zones)
+    per_source[zone.source_id] += 2;
+  size_t all_sources = 0;
+  for (const auto &rule : cfg.rules) {
+    if (rule.all_sources) {
+      all_sources++;
+    } else {
+      per_source[rule.source_id]++;
+    }
+  }
+  size_t most = 0;
+  for (const auto &entry : per_source)
+    most = std::max(most, entry.second);
+
+  auto sources = static_cast<size_t>(std::max(1, cfg.analytics.max_sources));
+  auto detections =
+      static_cast<size_t>(std::max(1, cfg.analytics.max_detections));
+  return sources * detections * (1 + most + all_sources);
+}
+
+} // namespace
+
+Consumer::Consumer(const Config &cfg)
+    : arena_(cfg.analytics.max_sources, cfg.analytics.max_detections),
+      pipeline_(cfg, arena_),
+      shedder_(cfg, static_cast<size_t>(std::max(
+                        {1, cfg.zmq.batch_size, cfg.pipeline.ring_capacity}))),
+      sources_(cfg.analytics.max_sources),
+      columns_(static_cast<size_t>(cfg.analytics.max_detections)),
+      states_(static_cast<size_t>(std::max(1, cfg.analytics.max_detections))),
+      summary_(static_cast<size_t>(cfg.analytics.max_detections)),
+      events_(event_capacity(cfg)),
+      log_events_(cfg.events.log),
+      heatmap_dir_(cfg.heatmap.cols > 0 ? cfg.heatmap.export_dir : ""),
+      fps_(cfg.analytics.fps) {
+  // Sources with configured zones, tripwires or rules take the first slots,
+  // so their sets can be built now; the rest are assigned on first sight.
+  for (const auto &zone : cfg.zones) {
+    sources_.slot(zone.source_id);
+  }
+  for (const auto &wire : cfg.tripwires) {
+    sources_.slot(wire.source_id);
+  }
+  for (const auto &rule : cfg.rules) {
+    if (!rule.all_sources)
+      sources_.slot(rule.source_id);
+  }
+
+  tracks_.reserve(sources_.capacity());
+  zones_.reserve(sources_.capacity());
+  tripwires_.reserve(sources_.capacity());
+  lifecycles_.reserve(sources_.capacity());
+  heatmaps_.reserve(sources_.capacity());
+  rules_.reserve(sources_.capacity());
+  for (size_t i = 0; i < sources_.capacity(); i++) {
+    tracks_.emplace_back(static_cast<size_t>(cfg.analytics.max_detections),
+                         cfg.analytics.track_ttl_frames,
+                         cfg.motion.enabled ? cfg.motion.alpha : 0.0f,
+                         cfg.motion.beta);
+    lifecycles_.emplace_back(cfg, tracks_.back().capacity());
+    if (i < sources_.size()) {
+      zones_.emplace_back(cfg, sources_.id(i));
+      tripwires_.emplace_back(cfg, sources_.id(i));
+      rules_.emplace_back(cfg, sources_.id(i), zones_.back());
+    } else {
+      zones_.emplace_back(); // nothing configured for later sources
+      tripwires_.emplace_back();
+      rules_.emplace_back(cfg); // all-source rules only
+    }
+    if (cfg.heatmap.cols > 0) {
+      heatmaps_.emplace_back(
+          cfg.heatmap, static_cast<size_t>(cfg.analytics.max_detections));
+    } else {
+      heatmaps_.emplace_back();
+    }
+  }
+}
+
+bool Consumer::consume(const char *data, size_t size) {
+  // ---------- hot path ----------
+  alloc_check_.begin();
+  arena_.reset();
+  events_.clear();
+  pipeline_.begin_message();
+
+  bool ok = pipeline_.decode(data, size, arena_);
+  if (ok) {
+    for (const auto &frame : arena_.views()) {
+      process(frame);
+    }
+  }
+  if (publish_ != nullptr && !events_.empty())
+    publish_events();
+
+  metrics_.on_frame();
+  alloc_check_.end();
+  // ------- end hot path ---------
+  if (log_events_ && !events_.empty())
+    log_events();
+  return ok;
+}
+
+void Consumer::consume_batch(zmq::message_t *msgs, size_t n) {
+  size_t kept = shedder_.apply(msgs, n);
+  metrics_.on_shed(n - kept);
+  for (size_t i = 0; i < kept; i++) {
+    consume(static_cast<const char *>(msgs[i].data()), msgs[i].size());
+  }
+}
+
+void Consumer::print_final_summary() const {
+  summary_.print_final(worker_, uniques());
+  pipeline_.print_final(worker_, sources_);
+  if (events_.dropped() > 0) {
+    std::cerr << "[EVENT]";
+    if (worker_ >= 0)
+      std::cerr << " w" << worker_;
+    std::cerr << " " << events_.dropped()
+              << " event(s) dropped on a full buffer\n";
+  }
+  if (pipeline_.filtering()) {
+    std::cerr << "[FILTER]";
+    if (worker_ >= 0)
+      std::cerr << " w" << worker_;
+    std::cerr << " " << arena_.filtered() << " detection(s) dropped\n";
+  }
+  if (publish_ != nullptr) {
+    std::cerr << "[PUBLISH]";
+    if (worker_ >= 0)
+      std::cerr << " w" << worker_;
+    std::cerr << " " << publish_dropped_
+              << " record(s) dropped on a full queue\n";
+  }
+}
+
+void Consumer::process(const FrameView &frame) {
+  int slot = sources_.slot(frame.source_id);
+  if (slot < 0)
+    return; // more distinct sources than max_sources
+
+  columns_.load(frame);
+
+  auto s = static_cast<size_t>(slot);
+  TrackTable &tracks = tracks_[s];
+  TrackLifecycle &lifecycle = lifecycles_[s];
+  ZoneSet &zones = zones_[s];
+  lifecycle.advance(tracks, frame.source_id, frame.frame_num, events_);
+
+  bool has_zones = zones.size() > 0;
+  if (has_zones)
+    zones.evaluate(columns_);
+
+  // A frame without a frame number has no place in its tracks' histories:
+  // it is counted, but not tracked and raises no events.
+  if (frame.frame_num == kNoFrameNum) {
+    aggregate(s);
+    return;
+  }
+
+  const int32_t *cls = columns_.class_id();
+  bool has_motion = tracks.has_motion();
+  for (size_t i = 0; i < columns_.size(); i++) {
+    TrackTable::Observation seen =
+        tracks.observe(frame.detections[i], frame.frame_num);
+    if (has_motion && seen.state != nullptr) {
+      TrackMotion before = tracks.motion(*seen.state);
+      columns_.set_previous(i, before.x, before.y);
+    } else {
+      columns_.set_previous(i, seen.previous);
+    }
+    switch (seen.lookup) {
+    case TrackLookup::kHit:
+      metrics_.record_cache_hit();
+      break;
+    case TrackLookup::kMiss:
+      metrics_.record_cache_miss();
+      lifecycle.track_started(*seen.state);
+      break;
+    case TrackLookup::kDropped:
+      break;
+    }
+    if (has_zones && seen.state != nullptr) {
+      lifecycle.update_zones(*seen.state,
+                             zones.zones_of(i) & zones.zones_counting(cls[i]),
+                             zones, frame.source_id, frame.frame_num, events_);
+    }
+  }
+
+  RuleSet &rules = rules_[s];
+  bool has_rules = rules.size() > 0;
+  if (has_motion || has_rules) {
+    // Tripwires and the aggregators below see smoothed anchors; zones above
+    // tested the raw ones. Found again after all inserts, so the states
+    // stay valid for the rules.
+    if (has_motion)
+      tracks.update_motion(frame.frame_num);
+    const int32_t *track = columns_.track_id();
+    for (size_t i = 0; i < columns_.size(); i++) {
+      TrackState *state = tracks.find(track[i]);
+      states_[i] = state;
+      if (has_motion && state != nullptr) {
+        TrackMotion m = tracks.motion(*state);
+        columns_.set_motion(i, m.x, m.y, m.vx, m.vy);
+      }
+    }
+  }
+
+  aggregate(s);
+
+  TripwireSet &tripwires = tripwires_[s];
+  if (tripwires.size() > 0)
+    tripwires.evaluate(columns_, events_);
+  if (has_rules)
+    rules.evaluate(columns_, zones, states_.data(), events_);
+}
+
+void Consumer::aggregate(size_t slot) {
+  summary_.add_frame(columns_);
+  Heatmap &heatmap = heatmaps_[slot];
+  if (heatmap.enabled())
+    heatmap.add_frame(columns_);
+  pipeline_.add_frame(slot, columns_);
+}
+
+void Consumer::log_events() const {
+  for (const auto &event : events_) {
+    auto slot = static_cast<size_t>(sources_.find(event.source_id));
+    std::cerr << "[EVENT]";
+    if (worker_ >= 0)
+      std::cerr << " w" << worker_;
+    std::cerr << " source " << event.source_id << " frame " << event.frame_num
+              << " track " << event.track_id << " class " << event.class_id;
+    switch (event.type) {
+    case EventType::kLineCrossing:
+      std::cerr << ": line " << tripwires_[slot].name(event.index)
+                << (event.direction > 0 ? " in" : " out");
+      break;
+    case EventType::kZoneEnter:
+      std::cerr << ": enter " << zones_[slot].name(event.index);
+      break;
+    case EventType::kZoneExit:
+      std::cerr << ": exit " << zones_[slot].name(event.index);
+      break;
+    case EventType::kLoitering:
+      std::cerr << ": loitering in " << zones_[slot].name(event.index);
+      break;
+    case EventType::kTrackEnd:
+      std::cerr << ": ended";
+      break;
+    case EventType::kRule:
+      std::cerr << ": rule " << rules_[slot].name(event.index);
+      break;
+    }
+    if (event.type != EventType::kLineCrossing &&
+        event.type != EventType::kZoneEnter && event.value >= 0) {
+      std::cerr << " after " << event.value << " frames ("
+                << static_cast<double>(event.value) / fps_ << " s)";
+    }
+    std::cerr << "\n";
+  }
+}
+
+void Consumer::report_dropped_events() {
+  std::cerr << "[EVENT]";
+  if (worker_ >= 0)
+    std::cerr << " w" << worker_;
+  std::cerr << " " << events_.dropped() - dropped_events_seen_
+            << " event(s) dropped on a full buffer\n";
+  dropped_events_seen_ = events_.dropped();
+}
+
+void Consumer::publish_events() {
+  PublishRecord record;
+  record.kind = PublishRecord::Kind::kEvent;
+  for (const auto &event : events_) {
+    record.event = event;
+    publish(record);
+  }
+  record.kind = PublishRecord::Kind::kEndOfMessage;
+  publish(record);
+}
+
+void Consumer::publish_snapshot() {
+  PublishRecord record;
+  record.kind = PublishRecord::Kind::kSnapshot;
+  for (size_t slot = 0; slot < sources_.size(); slot++) {
+    int32_t source_id = sources_.id(slot);
+    record.snapshot = SnapshotRecord{
+        SnapshotType::kTracks, 0, 0, source_id,
+        static_cast<uint32_t>(tracks_[slot].size())};
+    publish(record);
+    const ZoneSet &zones = zones_[slot];
+    for (size_t z = 0; z < zones.size(); z++) {
+      record.snapshot =
+          SnapshotRecord{SnapshotType::kZone, 0, static_cast<uint16_t>(z),
+                         source_id, zones.occupancy(z)};
+      publish(record);
+    }
+  }
+  record.kind = PublishRecord::Kind::kEndOfSnapshot;
+  publish(record);
+}
+
+void Consumer::export_heatmaps() {
+  for (size_t slot = 0; slot < sources_.size(); slot++) {
+    heatmaps_[slot].export_to(heatmap_dir_ + "/heatmap_" +
+                              std::to_string(sources_.id(slot)) + ".bin");
+  }
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "analytics/alloc_check.h"
+#include "analytics/events.h"
+#include "analytics/frame_arena.h"
+#include "analytics/frame_columns.h"
+#include "analytics/heatmap.h"
+#include "analytics/metrics.h"
+#include "analytics/overload.h"
+#include "analytics/pipeline.h"
+#include "analytics/proximity.h"
+#include "analytics/publisher.h"
+#include "analytics/report_tick.h"
+#include "analytics/rules.h"
+#include "analytics/source_index.h"
+#include "analytics/summary.h"
+#include "analytics/track_lifecycle.h"
+#include "analytics/track_table.h"
+#include "analytics/tripwires.h"
+#include "analytics/unique_tracks.h"
+#include "analytics/windows.h"
+#include "analytics/zones.h"
+#include "common/config.h"
+#include <zmq.hpp>
+
+// Decode, filter and the per-frame aggregators, composed at compile time
+// (see pipeline.h); add or drop a stage here.
+using ConsumerPipeline = Pipeline<WireDecoder, DetectionFilter, UniqueTracks,
+                                  SlidingWindows, Proximity>;
+
+// Decode + analytics state owned by exactly one thread. Everything here is
+// allocated at construction; `consume` runs the hot path for one payload.
+class Consumer {
+public:
+  explicit Consumer(const Config &cfg);
+
+  Consumer(const Consumer &) = delete;
+  Consumer &operator=(const Consumer &) = delete;
+
+  // Decodes one payload and runs analytics over its frames. Returns false if
+  // the payload was malformed.
+  bool consume(const char *data, size_t size);
+
+  // Applies the overload policy to `msgs[0, n)` (which may reorder and
+  // clear entries), then consumes what is left in order.
+  void consume_batch(zmq::message_t *msgs, size_t n);
+
+  const Shedder &shedder() const { return shedder_; }
+
+  // Per-source track state; `tracks(slot)` for slot < sources().size().
+  const SourceIndex &sources() const { return sources_; }
+  const TrackTable &tracks(size_t slot) const { return tracks_[slot]; }
+
+  // Events of the last consumed payload.
+  const EventBuffer &events() const { return events_; }
+
+  Metrics &metrics() { return metrics_; }
+  const Summary &summary() const { return summary_; }
+  // Null when the stage is not in ConsumerPipeline.
+  const UniqueTracks *uniques() const {
+    return pipeline_.find<UniqueTracks>();
+  }
+  const SlidingWindows *windows() const {
+    return pipeline_.find<SlidingWindows>();
+  }
+  const Proximity *proximity() const { return pipeline_.find<Proximity>(); }
+
+  // Tags report lines with a worker id (pool modes).
+  void set_worker(int id) {
+    worker_ = id;
+    metrics_.set_worker(id);
+  }
+
+  // Publishes events and report snapshots through `queue` (see
+  // publisher.h), which this thread must be the only writer of.
+  void set_publish_queue(PublishQueue *queue) { publish_ = queue; }
+
+  // Prints metrics and the analytics summary if a report was requested
+  // since the last call. Cheap enough to call after every batch.
+  void maybe_report() {
+    if (!report_tick_.due())
+      return;
+    metrics_.report();
+    summary_.print_interval(worker_, uniques());
+    pipeline_.print_interval(worker_, sources_);
+    for (size_t slot = 0; slot < sources_.size(); slot++) {
+      zones_[slot].print_interval(worker_, sources_.id(slot));
+      tripwires_[slot].print_interval(worker_, sources_.id(slot));
+      lifecycles_[slot].print_interval(worker_, sources_.id(slot));
+      heatmaps_[slot].print_interval(worker_, sources_.id(slot));
+      rules_[slot].print_interval(worker_, sources_.id(slot));
+      if (tracks_[slot].has_motion())
+        tracks_[slot].print_motion(worker_, sources_.id(slot), fps_);
+    }
+    if (!heatmap_dir_.empty())
+      export_heatmaps();
+    if (publish_ != nullptr)
+      publish_snapshot();
+    if (events_.dropped() != dropped_events_seen_)
+      report_dropped_events();
+  }
+
+  void print_final_summary() const;
+
+private:
+  void process(const FrameView &frame);
+  void aggregate(size_t slot);
+  void log_events() const;
+  void export_heatmaps();
+  void publish_events();
+  void publish_snapshot();
+  void report_dropped_events();
+
+  // Never waits: a record that finds the queue full is dropped.
+  void publish(PublishRecord &record) {
+    if (!publish_->try_push(record))
+      publish_dropped_++;
+  }
+
+  FrameArena arena_;
+  ConsumerPipeline pipeline_;
+  Metrics metrics_;
+  AllocCheck alloc_check_;
+  Shedder shedder_;
+
+  SourceIndex sources_;
+  std::vector<TrackTable> tracks_;         // by source slot
+  std::vector<TrackLifecycle> lifecycles_; // by source slot
+  std::vector<ZoneSet> zones_;             // by source slot
+  std::vector<TripwireSet> tripwires_;     // by source slot
+  std::vector<Heatmap> heatmaps_;          // by source slot
+  std::vector<RuleSet> rules_;             // by source slot
+
+  FrameColumns columns_;             // frame being processed, as SoA
+  std::vector<TrackState *> states_; // track of each detection of columns_
+  Summary summary_;
+  EventBuffer events_;
+  bool log_events_;
+  std::string heatmap_dir_;
+  int fps_;
+  ReportTick report_tick_;
+  int worker_ = -1;
+  uint64_t dropped_events_seen_ = 0; // events_.dropped() at the last report
+  PublishQueue *publish_ = nullptr;  // null = not publishing
+  uint64_t publish_dropped_ = 0;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+#include "common/config.h"
+
+// ================= Detection filter =================
+//
+// `[filter]` in config.toml: the classes worth analysing and a confidence
+// floor. The decoders apply it while reading each detection (see
+// pipeline.h), so a rejected detection never reaches the frame buffer, the
+// track table or any analytic, and downstream work shrinks with the
+// filtered fraction. The JSON decoder decides as soon as a detection's
+// class_id and confidence have been read and ignores the rest of the object;
+// the binary decoder copies only the kept detections out of the message.
+
+class DetectionFilter {
+public:
+  explicit DetectionFilter(const Config &cfg)
+      : all_classes_(cfg.filter.classes.empty()),
+        min_confidence_(cfg.filter.min_confidence),
+        active_(!all_classes_ || min_confidence_ > 0.0f) {
+    for (int c : cfg.filter.classes) {
+      if (c >= 0 && c < 256)
+        class_mask_[c / 64] |= uint64_t{1} << (c % 64);
+    }
+  }
+
+  // False without `[filter]` settings; decoders then skip the check.
+  bool active() const { return active_; }
+
+  // Branch-free; a NaN confidence passes the floor.
+  bool keep(int32_t class_id, float confidence) const {
+    auto c = static_cast<uint32_t>(class_id);
+    uint64_t bit = (class_mask_[(c / 64) & 3] >> (c % 64)) & 1;
+    bool cls = all_classes_ | ((c < 256) & (bit != 0));
+    return cls & !(confidence < min_confidence_);
+  }
+
+private:
+  uint64_t class_mask_[4] = {}; // classes kept, bit per id < 256
+  bool all_classes_;
+  float min_confidence_;
+  bool active_;
+};
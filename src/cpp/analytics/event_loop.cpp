@@ -0,0 +1,201 @@
+#include "analytics/event_loop.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "analytics/spin_wait.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+// epoll user data: kind in the high half, index in the low half.
+constexpr uint64_t kSocketTag = 1ull << 32;
+constexpr uint64_t kTimerTag = 2ull << 32;
+constexpr uint64_t kWakeTag = 3ull << 32;
+constexpr uint64_t kIndexMask = 0xffffffffull;
+
+void watch(int epoll_fd, int fd, uint64_t tag) {
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.u64 = tag;
+  if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0)
+    std::cerr << "[LOOP] epoll_ctl failed\n";
+}
+#endif
+
+inline bool readable(zmq::socket_t &socket) {
+  return (socket.get(zmq::sockopt::events) & ZMQ_POLLIN) != 0;
+}
+
+} // namespace
+
+EventLoop::EventLoop() {
+#ifdef __linux__
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  watch(epoll_fd_, wake_fd_, kWakeTag);
+#endif
+}
+
+EventLoop::~EventLoop() {
+#ifdef __linux__
+  for (auto &timer : timers_) {
+    ::close(timer.fd);
+  }
+  ::close(wake_fd_);
+  ::close(epoll_fd_);
+#endif
+}
+
+void EventLoop::add_socket(zmq::socket_t &socket, Callback on_readable) {
+  sockets_.push_back(Socket{&socket, std::move(on_readable)});
+#ifdef __linux__
+  watch(epoll_fd_, socket.get(zmq::sockopt::fd),
+        kSocketTag | (sockets_.size() - 1));
+#endif
+  // Messages may already be queued; ZMQ_FD will not signal for those.
+  sockets_.back().pending = true;
+}
+
+void EventLoop::add_timer(std::chrono::milliseconds period,
+                          Callback on_expiry) {
+  Timer timer;
+  timer.period = std::max(period, std::chrono::milliseconds(1));
+  timer.on_expiry = std::move(on_expiry);
+  timer.next = std::chrono::steady_clock::now() + timer.period;
+#ifdef __linux__
+  timer.fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  auto ms = timer.period.count();
+  itimerspec spec{};
+  spec.it_interval.tv_sec = ms / 1000;
+  spec.it_interval.tv_nsec = (ms % 1000) * 1000000;
+  spec.it_value = spec.it_interval;
+  ::timerfd_settime(timer.fd, 0, &spec, nullptr);
+  watch(epoll_fd_, timer.fd, kTimerTag | timers_.size());
+#endif
+  timers_.push_back(std::move(timer));
+}
+
+void EventLoop::stop() {
+  stopping_.store(true, std::memory_order_release);
+#ifdef __linux__
+  uint64_t one = 1;
+  ssize_t n = ::write(wake_fd_, &one, sizeof(one));
+  (void)n;
+#endif
+}
+
+int EventLoop::service(Socket &socket) {
+  for (int i = 0; i < kMaxBatchesPerWake; i++) {
+    if (!readable(*socket.socket)) {
+      socket.pending = false;
+      return i;
+    }
+    socket.on_readable();
+  }
+  socket.pending = readable(*socket.socket);
+  return kMaxBatchesPerWake;
+}
+
+void EventLoop::run() {
+#ifdef __linux__
+  run_epoll();
+#else
+  run_poll();
+#endif
+}
+
+// ---------- Linux: epoll + timerfd ----------
+
+void EventLoop::run_epoll() {
+#ifdef __linux__
+  constexpr int kMaxEvents = 16;
+  epoll_event events[kMaxEvents];
+  unsigned spins = 0;
+
+  while (!stopping_.load(std::memory_order_acquire)) {
+    int n = 0;
+    if (busy_poll_) {
+      for (auto &socket : sockets_) {
+        socket.pending = true;
+      }
+      if (++spins % kBusyPollTimerInterval == 0)
+        n = ::epoll_wait(epoll_fd_, events, kMaxEvents, 0);
+    } else {
+      bool any_pending =
+          std::any_of(sockets_.begin(), sockets_.end(),
+                      [](const Socket &s) { return s.pending; });
+      n = ::epoll_wait(epoll_fd_, events, kMaxEvents, any_pending ? 0 : -1);
+    }
+
+    for (int i = 0; i < n; i++) {
+      uint64_t tag = events[i].data.u64 & ~kIndexMask;
+      size_t index = static_cast<size_t>(events[i].data.u64 & kIndexMask);
+      if (tag == kSocketTag) {
+        sockets_[index].pending = true;
+      } else if (tag == kTimerTag) {
+        uint64_t expirations = 0;
+        if (::read(timers_[index].fd, &expirations, sizeof(expirations)) > 0)
+          timers_[index].on_expiry();
+      }
+      // kWakeTag: `stopping_` is checked below.
+    }
+
+    int handled = 0;
+    for (auto &socket : sockets_) {
+      if (socket.pending)
+        handled += service(socket);
+    }
+    if (busy_poll_ && handled == 0)
+      cpu_relax();
+  }
+#endif
+}
+
+// ---------- portable fallback: zmq::poll ----------
+
+void EventLoop::run_poll() {
+  std::vector<zmq::pollitem_t> items;
+  items.reserve(sockets_.size());
+  for (auto &socket : sockets_) {
+    items.push_back(
+        zmq::pollitem_t{socket.socket->handle(), 0, ZMQ_POLLIN, 0});
+  }
+
+  while (!stopping_.load(std::memory_order_acquire)) {
+    auto now = std::chrono::steady_clock::now();
+    // Bounded so `stop` from another thread is noticed.
+    auto timeout = std::chrono::milliseconds(100);
+    for (auto &timer : timers_) {
+      if (timer.next <= now) {
+        timer.on_expiry();
+        timer.next += timer.period;
+        if (timer.next <= now)
+          timer.next = now + timer.period; // skip missed periods
+      }
+      timeout = std::min(
+          timeout, std::chrono::duration_cast<std::chrono::milliseconds>(
+                       timer.next - now));
+    }
+
+    bool any_pending = std::any_of(sockets_.begin(), sockets_.end(),
+                                   [](const Socket &s) { return s.pending; });
+    if (any_pending || busy_poll_)
+      timeout = std::chrono::milliseconds(0);
+
+    zmq::poll(items.data(), items.size(), timeout);
+
+    for (size_t i = 0; i < sockets_.size(); i++) {
+      if (sockets_[i].pending || (items[i].revents & ZMQ_POLLIN))
+        service(sockets_[i]);
+    }
+  }
+}
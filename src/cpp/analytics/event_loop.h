@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <zmq.hpp>
+
+// Single-threaded readiness loop for ZMQ sockets and cold-path timers.
+//
+// On Linux each socket's ZMQ_FD and one timerfd per timer sit in an epoll
+// set; elsewhere it falls back to `zmq::poll` with a timeout up to the next
+// timer. Either way the clock is only read when a timer fires, never per
+// message, and one thread can serve several sockets.
+//
+// ZMQ_FD only signals that the socket's state *changed*, so a readable
+// callback is invoked while ZMQ_EVENTS still reports POLLIN. Each callback
+// should handle one batch; after `kMaxBatchesPerWake` the loop services the
+// other sockets and due timers, then comes back without waiting.
+class EventLoop {
+public:
+  using Callback = std::function<void()>;
+
+  EventLoop();
+  ~EventLoop();
+
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+
+  // `on_readable` must consume input (e.g. a non-blocking recv batch) or the
+  // loop will call it again straight away. Register before `run`.
+  void add_socket(zmq::socket_t &socket, Callback on_readable);
+
+  // Calls `on_expiry` every `period` from the loop thread.
+  void add_timer(std::chrono::milliseconds period, Callback on_expiry);
+
+  // Spin on the sockets instead of sleeping in epoll: lowest wake-up latency
+  // at the cost of a full core. Timers are still checked every
+  // `kBusyPollTimerInterval` spins.
+  void set_busy_poll(bool busy_poll) { busy_poll_ = busy_poll; }
+
+  // Runs until `stop`.
+  void run();
+
+  // Safe from any thread and from a signal handler.
+  void stop();
+
+private:
+  static constexpr int kMaxBatchesPerWake = 64;
+  static constexpr unsigned kBusyPollTimerInterval = 1024;
+
+  struct Socket {
+    zmq::socket_t *socket;
+    Callback on_readable;
+    bool pending = false; // still readable after the last wake-up
+  };
+
+  struct Timer {
+    std::chrono::milliseconds period;
+    Callback on_expiry;
+    int fd = -1;                                // Linux
+    std::chrono::steady_clock::time_point next; // fallback
+  };
+
+  // Runs up to kMaxBatchesPerWake readable callbacks, updates `pending`,
+  // and returns how many ran.
+  static int service(Socket &socket);
+
+  void run_epoll();
+  void run_poll();
+
+  std::vector<Socket> sockets_;
+  std::vector<Timer> timers_;
+  std::atomic<bool> stopping_{false};
+  bool busy_poll_ = false;
+
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1; // eventfd written by `stop`
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ================= Analytics events =================
+//
+// Discrete things that happened on a frame (a track crossed a line, left a
+// zone, ...), as opposed to the per-interval counters each analytic keeps.
+// Events are fixed-size PODs appended to a buffer that is reserved up front
+// and cleared after every message, so producing them never allocates.
+
+enum class EventType : uint8_t {
+  kLineCrossing, // index = tripwire, direction = +1 in / -1 out
+  kZoneEnter,    // index = zone
+  kZoneExit,     // index = zone, value = dwell
+  kLoitering,    // index = zone, value = dwell so far
+  kTrackEnd,     // value = lifetime (first to last seen)
+  kRule,         // index = rule; the rule became true for the track
+};
+
+struct AnalyticsEvent {
+  EventType type;
+  int8_t direction;
+  uint16_t index; // tripwire / zone within the source
+  int32_t source_id;
+  int32_t frame_num;
+  int32_t track_id;
+  int32_t class_id;
+  int32_t value; // frames; see EventType
+};
+
+class EventBuffer {
+public:
+  explicit EventBuffer(size_t capacity) { events_.reserve(capacity); }
+
+  // Drops (and counts) the event when the buffer is full.
+  void push(const AnalyticsEvent &event) {
+    if (events_.size() == events_.capacity()) {
+      dropped_++;
+      return;
+    }
+    events_.push_back(event);
+  }
+
+  void clear() { events_.clear(); }
+
+  bool empty() const { return events_.empty(); }
+  size_t size() const { return events_.size(); }
+  const AnalyticsEvent *begin() const { return events_.data(); }
+  const AnalyticsEvent *end() const { return events_.data() + events_.size(); }
+
+  // Events lost to a full buffer since construction.
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  std::vector<AnalyticsEvent> events_;
+  uint64_t dropped_ = 0;
+};
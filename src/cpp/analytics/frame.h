@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Fixed-layout detection record (mirrors DeepStream NvDsObjectMeta fields
+// the analytics side actually reads). Hot fields first, no pointers.
+struct BBox {
+  float left;
+  float top;
+  float width;
+  float height;
+};
+
+struct Detection {
+  int32_t track_id;
+  int32_t class_id;
+  float confidence;
+  BBox bbox;
+};
+
+// `frame_num` of a frame that carried none: JSON has it only per detection,
+// so a source with no detections (`"0": []`) has no frame number.
+constexpr int32_t kNoFrameNum = INT32_MIN;
+
+// One source's detections for one frame. `uri` and `frame_num` are repeated
+// per detection on the wire but stored once per frame here.
+struct Frame {
+  int32_t source_id = 0;
+  int32_t frame_num = kNoFrameNum;
+  std::string uri;
+  std::vector<Detection> detections;
+};
+
+// Read-only view of one frame's detections. Points either into a decoded
+// `Frame` or directly into a received binary message (see wire_format.h);
+// analytics consume views so both formats share one path.
+struct FrameView {
+  int32_t source_id = 0;
+  int32_t frame_num = 0;
+  std::string_view uri;
+  const Detection *detections = nullptr;
+  size_t count = 0;
+
+  const Detection *begin() const { return detections; }
+  const Detection *end() const { return detections + count; }
+};
+
+inline FrameView view_of(const Frame &frame) {
+  FrameView view;
+  view.source_id = frame.source_id;
+  view.frame_num = frame.frame_num;
+  view.uri = frame.uri;
+  view.detections = frame.detections.data();
+  view.count = frame.detections.size();
+  return view;
+}
@@ -0,0 +1,37 @@
+#include "analytics/frame_arena.h"
+
+namespace {
+
+void prepare(Frame &frame, size_t max_detections) {
+  frame.detections.reserve(max_detections);
+  frame.uri.reserve(FrameArena::kUriCapacity);
+}
+
+void clear(Frame &frame) {
+  frame.source_id = 0;
+  frame.frame_num = kNoFrameNum;
+  frame.uri.clear();
+  frame.detections.clear();
+}
+
+} // namespace
+
+FrameArena::FrameArena(int max_sources, int max_detections)
+    : frames_(static_cast<size_t>(max_sources > 0 ? max_sources : 1)),
+      max_detections_(static_cast<size_t>(max_detections > 0 ? max_detections
+                                                             : 0)),
+      decoder_pool_(new unsigned char[kDecoderPoolBytes]) {
+  for (auto &frame : frames_) {
+    prepare(frame, max_detections_);
+  }
+  prepare(overflow_, max_detections_);
+  views_.reserve(frames_.size());
+}
+
+Frame &FrameArena::acquire() {
+  Frame &frame = used_ < frames_.size() ? frames_[used_++] : overflow_;
+  if (&frame == &overflow_)
+    dropped_frames_++;
+  clear(frame);
+  return frame;
+}
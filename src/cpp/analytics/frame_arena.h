@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "analytics/frame.h"
+
+// Frame-scoped arena: everything the hot loop needs to decode and hold one
+// message, allocated once at startup and reset (never freed) per message.
+//
+//   - a pool of `max_sources` frames, each with `max_detections` reserved
+//   - up to `max_sources` FrameViews handed to analytics
+//   - a fixed block backing the JSON reader's internal stack
+//
+// After the first few messages have warmed it up, decoding into an arena does
+// no heap allocation.
+class FrameArena {
+public:
+  static constexpr size_t kDecoderPoolBytes = 16 * 1024;
+  static constexpr size_t kUriCapacity = 256;
+
+  FrameArena(int max_sources, int max_detections);
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  // Start a new message: drops all frames, keeps capacity.
+  void reset() {
+    used_ = 0;
+    views_.clear();
+  }
+
+  // Next pooled frame, cleared. Once the pool is exhausted, returns a shared
+  // overflow frame that is not part of the iteration range.
+  Frame &acquire();
+
+  Frame *begin() { return frames_.data(); }
+  Frame *end() { return frames_.data() + used_; }
+  const Frame *begin() const { return frames_.data(); }
+  const Frame *end() const { return frames_.data() + used_; }
+  size_t size() const { return used_; }
+
+  size_t max_detections() const { return max_detections_; }
+
+  // Views for the current message, in decode order. Returns false (and
+  // counts a dropped frame) once `max_sources` views are held.
+  bool add_view(const FrameView &view) {
+    if (views_.size() == views_.capacity()) {
+      dropped_frames_++;
+      return false;
+    }
+    views_.push_back(view);
+    return true;
+  }
+  const std::vector<FrameView> &views() const { return views_; }
+
+  void *decoder_pool() { return decoder_pool_.get(); }
+  size_t decoder_pool_size() const { return kDecoderPoolBytes; }
+
+  // Frames that did not fit in `max_sources`.
+  uint64_t dropped_frames() const { return dropped_frames_; }
+
+  // Detections beyond `max_detections` in one frame are dropped by decoders;
+  // this counts them.
+  void note_truncated(uint64_t n) { truncated_ += n; }
+  uint64_t truncated() const { return truncated_; }
+
+  // Detections the decoders' filter rejected (see detection_filter.h).
+  void note_filtered(uint64_t n) { filtered_ += n; }
+  uint64_t filtered() const { return filtered_; }
+
+private:
+  std::vector<Frame> frames_;
+  size_t used_ = 0;
+  size_t max_detections_;
+  Frame overflow_;
+  std::vector<FrameView> views_;
+  uint64_t dropped_frames_ = 0;
+  uint64_t truncated_ = 0;
+  uint64_t filtered_ = 0;
+
+  std::unique_ptr<unsigned char[]> decoder_pool_;
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "analytics/aligned.h"
+#include "analytics/frame.h"
+
+// Structure-of-arrays copy of one frame's detections: each field in its own
+// contiguous, cache-line-aligned column, so per-field loops (counting,
+// thresholds, geometry) stream one array and vectorize. Sized once for
+// `max_detections`; `load` transposes a FrameView into it.
+//
+// The anchor columns hold each box's bottom-centre, where the object meets
+// the ground; zones and tripwires test that point. The previous-anchor
+// columns are filled per detection from the track table (`set_previous`),
+// so line crossings can be tested over the whole frame at once. With the
+// motion filter on, both anchors are replaced by the track's smoothed
+// positions once its detections are observed, and the velocity columns
+// (pixels per frame, otherwise 0) are filled.
+class FrameColumns {
+public:
+  explicit FrameColumns(size_t max_detections)
+      : stride_(round_up_to_line<float>(max_detections > 0 ? max_detections
+                                                           : 1)),
+        capacity_(max_detections),
+        ints_(make_aligned_array<int32_t>(stride_ * kIntColumns)),
+        floats_(make_aligned_array<float>(stride_ * kFloatColumns)) {}
+
+  // ---------- hot path ----------
+
+  void load(const FrameView &frame) {
+    size_t n = frame.count < capacity_ ? frame.count : capacity_;
+    const Detection *det = frame.detections;
+    int32_t *track = track_id();
+    int32_t *cls = class_id();
+    float *conf = confidence();
+    float *l = left();
+    float *t = top();
+    float *w = width();
+    float *h = height();
+    for (size_t i = 0; i < n; i++) {
+      track[i] = det[i].track_id;
+      cls[i] = det[i].class_id;
+      conf[i] = det[i].confidence;
+      l[i] = det[i].bbox.left;
+      t[i] = det[i].bbox.top;
+      w[i] = det[i].bbox.width;
+      h[i] = det[i].bbox.height;
+    }
+    float *ax = anchor_x();
+    float *ay = anchor_y();
+    float *vx = velocity_x();
+    float *vy = velocity_y();
+    for (size_t i = 0; i < n; i++) {
+      ax[i] = l[i] + 0.5f * w[i];
+      ay[i] = t[i] + h[i];
+      vx[i] = 0.0f;
+      vy[i] = 0.0f;
+    }
+    source_id_ = frame.source_id;
+    frame_num_ = frame.frame_num;
+    size_ = n;
+  }
+
+  // Records where detection `i`'s track was on its last frame.
+  void set_previous(size_t i, const BBox &prev) {
+    prev_anchor_x()[i] = prev.left + 0.5f * prev.width;
+    prev_anchor_y()[i] = prev.top + prev.height;
+  }
+
+  // Same, from the track's smoothed position on its last frame.
+  void set_previous(size_t i, float x, float y) {
+    prev_anchor_x()[i] = x;
+    prev_anchor_y()[i] = y;
+  }
+
+  // Replaces detection `i`'s anchor with its track's smoothed position.
+  void set_motion(size_t i, float x, float y, float vx, float vy) {
+    anchor_x()[i] = x;
+    anchor_y()[i] = y;
+    velocity_x()[i] = vx;
+    velocity_y()[i] = vy;
+  }
+
+  size_t size() const { return size_; }
+  int32_t source_id() const { return source_id_; }
+  int32_t frame_num() const { return frame_num_; }
+
+  // Columns, each `size()` long (and padded to a whole cache line).
+  int32_t *track_id() { return ints_.get(); }
+  int32_t *class_id() { return ints_.get() + stride_; }
+  float *confidence() { return floats_.get(); }
+  float *left() { return floats_.get() + stride_; }
+  float *top() { return floats_.get() + 2 * stride_; }
+  float *width() { return floats_.get() + 3 * stride_; }
+  float *height() { return floats_.get() + 4 * stride_; }
+  float *anchor_x() { return floats_.get() + 5 * stride_; }
+  float *anchor_y() { return floats_.get() + 6 * stride_; }
+  float *prev_anchor_x() { return floats_.get() + 7 * stride_; }
+  float *prev_anchor_y() { return floats_.get() + 8 * stride_; }
+  float *velocity_x() { return floats_.get() + 9 * stride_; }
+  float *velocity_y() { return floats_.get() + 10 * stride_; }
+
+  const int32_t *track_id() const { return ints_.get(); }
+  const int32_t *class_id() const { return ints_.get() + stride_; }
+  const float *confidence() const { return floats_.get(); }
+  const float *left() const { return floats_.get() + stride_; }
+  const float *top() const { return floats_.get() + 2 * stride_; }
+  const float *width() const { return floats_.get() + 3 * stride_; }
+  const float *height() const { return floats_.get() + 4 * stride_; }
+  const float *anchor_x() const { return floats_.get() + 5 * stride_; }
+  const float *anchor_y() const { return floats_.get() + 6 * stride_; }
+  const float *prev_anchor_x() const { return floats_.get() + 7 * stride_; }
+  const float *prev_anchor_y() const { return floats_.get() + 8 * stride_; }
+  const float *velocity_x() const { return floats_.get() + 9 * stride_; }
+  const float *velocity_y() const { return floats_.get() + 10 * stride_; }
+
+private:
+  static constexpr size_t kIntColumns = 2;
+  static constexpr size_t kFloatColumns = 11;
+
+  size_t stride_;
+  size_t capacity_;
+  AlignedArray<int32_t> ints_;
+  AlignedArray<float> floats_;
+  size_t size_ = 0;
+  int32_t source_id_ = 0;
+  int32_t frame_num_ = 0;
+};
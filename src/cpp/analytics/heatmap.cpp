@@ -0,0 +1,251 @@
+#include "analytics/heatmap.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// Decay steps per half-life.
+constexpr int32_t kDecaySteps = 8;
+
+constexpr uint16_t kSaturated = 0xffff;
+
+void tag(int worker) {
+  std::cerr << "[HEATMAP]";
+  if (worker >= 0)
+    std::cerr << " w" << worker;
+}
+
+} // namespace
+
+Heatmap::Heatmap(const HeatmapConfig &cfg, size_t max_detections)
+    : cols_(static_cast<size_t>(cfg.cols)),
+      rows_(static_cast<size_t>(cfg.rows)),
+      tiles_across_((cols_ + kTileCols - 1) / kTileCols),
+      scale_x_(static_cast<float>(cfg.cols) / cfg.frame_width),
+      scale_y_(static_cast<float>(cfg.rows) / cfg.frame_height),
+      mode_(cfg.mode) {
+  size_t tiles_down = (rows_ + kTileRows - 1) / kTileRows;
+  size_ = tiles_across_ * tiles_down * kTileCells;
+  cells_ = make_aligned_array<uint16_t>(size_);
+
+  size_t scratch =
+      round_up_to_line<uint32_t>(std::max<size_t>(1, max_detections));
+  index_ = make_aligned_array<uint32_t>(scratch);
+  if (mode_ == HeatmapMode::kBox) {
+    col1_ = make_aligned_array<uint32_t>(scratch);
+    row0_ = make_aligned_array<uint32_t>(scratch);
+    row1_ = make_aligned_array<uint32_t>(scratch);
+  }
+
+  if (cfg.half_life_frames > 0) {
+    decay_step_ = std::max(1, cfg.half_life_frames / kDecaySteps);
+    double per_step = -static_cast<double>(decay_step_) / cfg.half_life_frames;
+    // Up to the step count after which every counter is 0.
+    for (int k = 0;; k++) {
+      auto mul = static_cast<uint32_t>(65536.0 * std::exp2(k * per_step));
+      if (mul == 0)
+        break;
+      decay_mul_.push_back(std::min<uint32_t>(mul, k == 0 ? 65536 : 65535));
+    }
+  }
+
+  snapshot_.resize(cols_ * rows_);
+}
+
+void Heatmap::add_frame(const FrameColumns &frame) {
+  if (decay_step_ > 0 && frame.frame_num() != kNoFrameNum)
+    decay_to(frame.frame_num());
+
+  if (mode_ == HeatmapMode::kBox) {
+    add_boxes(frame);
+  } else {
+    add_points(frame);
+  }
+  hits_ += frame.size();
+}
+
+void Heatmap::decay_to(int32_t frame_num) {
+  if (frame_num < decayed_at_ && started_) {
+    // A late frame changes nothing; only a step back of more than a
+    // half-life is a restarted source.
+    if (int64_t{decayed_at_} - frame_num <= int64_t{decay_step_} * kDecaySteps)
+      return;
+    started_ = false;
+  }
+  if (!started_) {
+    // First frame, or the source restarted: start the decay clock over.
+    started_ = true;
+    decayed_at_ = frame_num;
+    return;
+  }
+  int64_t steps = (int64_t{frame_num} - decayed_at_) / decay_step_;
+  if (steps == 0)
+    return;
+  decayed_at_ = static_cast<int32_t>(decayed_at_ + steps * decay_step_);
+
+  uint16_t *cells = cells_.get();
+  if (steps >= static_cast<int64_t>(decay_mul_.size())) {
+    std::fill(cells, cells + size_, uint16_t{0});
+    return;
+  }
+  // (count * mul) >> 16 on 16-bit lanes: a high-half multiply.
+  auto mul = static_cast<uint16_t>(decay_mul_[static_cast<size_t>(steps)]);
+  for (size_t i = 0; i < size_; i++) {
+    cells[i] = static_cast<uint16_t>((uint32_t{cells[i]} * mul) >> 16);
+  }
+}
+
+void Heatmap::add_points(const FrameColumns &frame) {
+  const float *l = frame.left();
+  const float *t = frame.top();
+  const float *w = frame.width();
+  const float *h = frame.height();
+  // Anchor: bottom-centre; center: the box's centre.
+  float down = mode_ == HeatmapMode::kAnchor ? 1.0f : 0.5f;
+  float sx = scale_x_;
+  float sy = scale_y_;
+  float max_col = static_cast<float>(cols_ - 1);
+  float max_row = static_cast<float>(rows_ - 1);
+  auto tiles = static_cast<uint32_t>(tiles_across_);
+  uint32_t *index = index_.get();
+  size_t n = frame.size();
+
+  // std::max(0, v) first, so NaN lands on cell 0 rather than anywhere.
+  for (size_t i = 0; i < n; i++) {
+    float x = (l[i] + 0.5f * w[i]) * sx;
+    float y = (t[i] + down * h[i]) * sy;
+    auto c = static_cast<uint32_t>(
+        static_cast<int32_t>(std::min(max_col, std::max(0.0f, x))));
+    auto r = static_cast<uint32_t>(
+        static_cast<int32_t>(std::min(max_row, std::max(0.0f, y))));
+    index[i] = ((r / kTileRows) * tiles + c / kTileCols) * kTileCells +
+               (r % kTileRows) * kTileCols + c % kTileCols;
+  }
+
+  uint16_t *cells = cells_.get();
+  for (size_t i = 0; i < n; i++) {
+    uint16_t &v = cells[index[i]];
+    v = static_cast<uint16_t>(v + (v != kSaturated));
+  }
+}
+
+void Heatmap::add_boxes(const FrameColumns &frame) {
+  const float *l = frame.left();
+  const float *t = frame.top();
+  const float *w = frame.width();
+  const float *h = frame.height();
+  float sx = scale_x_;
+  float sy = scale_y_;
+  float max_col = static_cast<float>(cols_ - 1);
+  float max_row = static_cast<float>(rows_ - 1);
+  uint32_t *col0 = index_.get();
+  uint32_t *col1 = col1_.get();
+  uint32_t *row0 = row0_.get();
+  uint32_t *row1 = row1_.get();
+  size_t n = frame.size();
+
+  auto clamp_col = [max_col](float v) {
+    return static_cast<uint32_t>(
+        static_cast<int32_t>(std::min(max_col, std::max(0.0f, v))));
+  };
+  auto clamp_row = [max_row](float v) {
+    return static_cast<uint32_t>(
+        static_cast<int32_t>(std::min(max_row, std::max(0.0f, v))));
+  };
+  for (size_t i = 0; i < n; i++) {
+    col0[i] = clamp_col(l[i] * sx);
+    col1[i] = clamp_col((l[i] + w[i]) * sx);
+    row0[i] = clamp_row(t[i] * sy);
+    row1[i] = clamp_row((t[i] + h[i]) * sy);
+  }
+
+  uint16_t *cells = cells_.get();
+  for (size_t i = 0; i < n; i++) {
+    for (size_t r = row0[i]; r <= row1[i]; r++) {
+      uint16_t *line = cells + cell(0, r);
+      for (size_t c = col0[i]; c <= col1[i]; c++) {
+        uint16_t &v = line[(c / kTileCols) * kTileCells + c % kTileCols];
+        v = static_cast<uint16_t>(v + (v != kSaturated));
+      }
+    }
+  }
+}
+
+void Heatmap::snapshot(uint16_t *out) const {
+  for (size_t r = 0; r < rows_; r++) {
+    for (size_t c = 0; c < cols_; c++) {
+      out[r * cols_ + c] = cells_[cell(c, r)];
+    }
+  }
+}
+
+bool Heatmap::export_to(const std::string &path) {
+  snapshot(snapshot_.data());
+  std::string tmp = path + ".tmp";
+  int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    std::cerr << "[HEATMAP] cannot create " << tmp << ": "
+              << std::strerror(errno) << "\n";
+    return false;
+  }
+  const auto *p = reinterpret_cast<const char *>(snapshot_.data());
+  size_t left = snapshot_.size() * sizeof(uint16_t);
+  while (left > 0) {
+    ssize_t n = ::write(fd, p, left);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      std::cerr << "[HEATMAP] cannot write " << tmp << ": "
+                << std::strerror(errno) << "\n";
+      ::close(fd);
+      ::unlink(tmp.c_str());
+      return false;
+    }
+    p += n;
+    left -= static_cast<size_t>(n);
+  }
+  ::close(fd);
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::cerr << "[HEATMAP] cannot rename " << tmp << " to " << path << ": "
+              << std::strerror(errno) << "\n";
+    ::unlink(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+void Heatmap::print_interval(int worker, int32_t source_id) {
+  if (!enabled())
+    return;
+  uint16_t hottest = 0;
+  size_t hot_col = 0;
+  size_t hot_row = 0;
+  size_t saturated = 0;
+  for (size_t r = 0; r < rows_; r++) {
+    for (size_t c = 0; c < cols_; c++) {
+      uint16_t v = cells_[cell(c, r)];
+      if (v > hottest) {
+        hottest = v;
+        hot_col = c;
+        hot_row = r;
+      }
+      saturated += v == kSaturated;
+    }
+  }
+  tag(worker);
+  std::cerr << " source " << source_id << ": " << hits_
+            << " detections this interval, hottest cell (" << hot_col << ", "
+            << hot_row << ") = " << hottest;
+  if (saturated > 0)
+    std::cerr << ", " << saturated << " cells saturated";
+  std::cerr << "\n";
+  hits_ = 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "analytics/aligned.h"
+#include "analytics/frame_columns.h"
+#include "common/config.h"
+
+// ================= Heatmap =================
+//
+// Where objects have been on one source (`[heatmap]` in config.toml): a
+// cols x rows grid over the image, each cell a 16-bit saturating counter of
+// the detections that landed on it (or, in box mode, overlapped it).
+//
+// Cells are stored in tiles of 8 x 4 counters, one cache line each, so the
+// few cells a crowd or a box touches share lines instead of striding across
+// image rows. A frame first computes every detection's cell (or cell range)
+// in one branch-free pass over the SoA columns, which vectorizes, then
+// increments the counters.
+//
+// With a half-life, counts decay on the source's frame clock: every
+// half_life / 8 frames all counters are scaled by 2^(-1/8) in fixed point
+// (rounded down, so a cell no longer hit reaches 0).
+class Heatmap {
+public:
+  // A tile is kTileCols x kTileRows counters: one cache line.
+  static constexpr size_t kTileCols = 8;
+  static constexpr size_t kTileRows = 4;
+  static constexpr size_t kTileCells = kTileCols * kTileRows;
+
+  Heatmap(const HeatmapConfig &cfg, size_t max_detections);
+
+  // Off.
+  Heatmap() = default;
+
+  bool enabled() const { return cols_ > 0; }
+  size_t cols() const { return cols_; }
+  size_t rows() const { return rows_; }
+
+  // ---------- hot path ----------
+
+  // Decays to `frame`'s frame number, then adds its detections.
+  void add_frame(const FrameColumns &frame);
+
+  uint16_t at(size_t col, size_t row) const { return cells_[cell(col, row)]; }
+
+  // ---------- cold path ----------
+
+  // Copies the grid to `out` (rows x cols, row-major).
+  void snapshot(uint16_t *out) const;
+
+  // Writes the snapshot as a raw array of native-endian uint16_t to `path`
+  // (through a temporary file, so readers never see half of one).
+  bool export_to(const std::string &path);
+
+  // Prints hits since the last call, the hottest cell and saturation.
+  void print_interval(int worker, int32_t source_id);
+
+private:
+  size_t cell(size_t col, size_t row) const {
+    return ((row / kTileRows) * tiles_across_ + col / kTileCols) * kTileCells +
+           (row % kTileRows) * kTileCols + col % kTileCols;
+  }
+
+  void decay_to(int32_t frame_num);
+  void add_points(const FrameColumns &frame);
+  void add_boxes(const FrameColumns &frame);
+
+  size_t cols_ = 0;
+  size_t rows_ = 0;
+  size_t tiles_across_ = 0;
+  float scale_x_ = 0.0f; // cells per pixel
+  float scale_y_ = 0.0f;
+  HeatmapMode mode_ = HeatmapMode::kAnchor;
+
+  AlignedArray<uint16_t> cells_; // tile-major, padded to whole tiles
+  size_t size_ = 0;              // cells_ length
+
+  // Per-detection scratch: cell index, or the box's cell range.
+  AlignedArray<uint32_t> index_;
+  AlignedArray<uint32_t> col1_;
+  AlignedArray<uint32_t> row0_;
+  AlignedArray<uint32_t> row1_;
+
+  // Decay: factor after k steps (0.16 fixed point) for k < size.
+  int32_t decay_step_ = 0; // frames per step; 0 = no decay
+  std::vector<uint32_t> decay_mul_;
+  int32_t decayed_at_ = 0; // frame number of the last step
+  bool started_ = false;
+
+  std::vector<uint16_t> snapshot_; // export scratch
+  uint64_t hits_ = 0;              // since the last print
+};
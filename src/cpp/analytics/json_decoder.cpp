@@ -0,0 +1,358 @@
+#include "analytics/json_decoder.h"
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+enum class State {
+  kStart,      // before the root object
+  kSources,    // inside root object, expecting a source-id key
+  kSourceKey,  // after a source-id key, expecting its detection array
+  kDetections, // inside a detection array
+  kDetection,  // inside a detection object
+  kBBox,       // inside a detection's bbox object
+  kDone,
+};
+
+enum class Field {
+  kUnknown,
+  kUri,
+  kClassId,
+  kTrackId,
+  kConfidence,
+  kBBox,
+  kFrameNum,
+  kLeft,
+  kTop,
+  kWidth,
+  kHeight,
+};
+
+// Bits for the fields a detection must carry to be accepted.
+constexpr uint32_t kHasClassId = 1u << 0;
+constexpr uint32_t kHasTrackId = 1u << 1;
+constexpr uint32_t kHasConfidence = 1u << 2;
+constexpr uint32_t kHasLeft = 1u << 3;
+constexpr uint32_t kHasTop = 1u << 4;
+constexpr uint32_t kHasWidth = 1u << 5;
+constexpr uint32_t kHasHeight = 1u << 6;
+constexpr uint32_t kRequired = kHasClassId | kHasTrackId | kHasConfidence |
+                               kHasLeft | kHasTop | kHasWidth | kHasHeight;
+// Fields the detection filter decides on.
+constexpr uint32_t kFiltered = kHasClassId | kHasConfidence;
+
+inline bool key_is(const char *str, rapidjson::SizeType len, const char *lit,
+                   size_t lit_len) {
+  return len == lit_len && std::memcmp(str, lit, lit_len) == 0;
+}
+
+#define KEY_IS(lit) key_is(str, len, lit, sizeof(lit) - 1)
+
+Field detection_field(const char *str, rapidjson::SizeType len) {
+  if (KEY_IS("track_id"))
+    return Field::kTrackId;
+  if (KEY_IS("class_id"))
+    return Field::kClassId;
+  if (KEY_IS("confidence"))
+    return Field::kConfidence;
+  if (KEY_IS("bbox"))
+    return Field::kBBox;
+  if (KEY_IS("frame_num"))
+    return Field::kFrameNum;
+  if (KEY_IS("uri"))
+    return Field::kUri;
+  return Field::kUnknown;
+}
+
+Field bbox_field(const char *str, rapidjson::SizeType len) {
+  if (KEY_IS("left"))
+    return Field::kLeft;
+  if (KEY_IS("top"))
+    return Field::kTop;
+  if (KEY_IS("width"))
+    return Field::kWidth;
+  if (KEY_IS("height"))
+    return Field::kHeight;
+  return Field::kUnknown;
+}
+
+#undef KEY_IS
+
+struct Handler {
+  FrameArena &arena;
+  size_t max_detections;
+  const DetectionFilter *filter; // null = keep everything
+
+  State state = State::kStart;
+  Field field = Field::kUnknown;
+  uint32_t seen = 0;
+  int skip_depth = 0;    // > 0 while skipping an unknown nested value
+  bool rejected = false; // current detection dropped by the filter
+  Frame *frame = nullptr;
+  Detection det{};
+
+  // Once class and confidence are both read, a rejected detection's other
+  // fields are ignored (bbox as an unknown object), and it is neither
+  // validated nor stored.
+  void apply_filter() {
+    if (filter != nullptr && (seen & kFiltered) == kFiltered)
+      rejected = !filter->keep(det.class_id, det.confidence);
+  }
+
+  // ---------- scalar dispatch ----------
+
+  bool on_int(int64_t v) {
+    if (skip_depth > 0)
+      return true;
+    if (state == State::kDetection &&
+        (field == Field::kClassId || field == Field::kTrackId ||
+         field == Field::kFrameNum)) {
+      if (v < std::numeric_limits<int32_t>::min() ||
+          v > std::numeric_limits<int32_t>::max()) {
+        return false;
+      }
+      switch (field) {
+      case Field::kClassId:
+        det.class_id = static_cast<int32_t>(v);
+        seen |= kHasClassId;
+        apply_filter();
+        return true;
+      case Field::kTrackId:
+        det.track_id = static_cast<int32_t>(v);
+        seen |= kHasTrackId;
+        return true;
+      case Field::kFrameNum:
+        if (frame->detections.empty())
+          frame->frame_num = static_cast<int32_t>(v);
+        return true;
+      default:
+        break;
+      }
+    }
+    return on_double(static_cast<double>(v));
+  }
+
+  bool on_double(double v) {
+    if (skip_depth > 0)
+      return true;
+    if (state == State::kDetection) {
+      switch (field) {
+      case Field::kConfidence:
+        det.confidence = static_cast<float>(v);
+        seen |= kHasConfidence;
+        apply_filter();
+        return true;
+      case Field::kUnknown:
+        return true;
+      default:
+        return false; // integer field given a float, or bbox given a scalar
+      }
+    }
+    if (state == State::kBBox) {
+      switch (field) {
+      case Field::kLeft:
+        det.bbox.left = static_cast<float>(v);
+        seen |= kHasLeft;
+        return true;
+      case Field::kTop:
+        det.bbox.top = static_cast<float>(v);
+        seen |= kHasTop;
+        return true;
+      case Field::kWidth:
+        det.bbox.width = static_cast<float>(v);
+        seen |= kHasWidth;
+        return true;
+      case Field::kHeight:
+        det.bbox.height = static_cast<float>(v);
+        seen |= kHasHeight;
+        return true;
+      default:
+        return true; // border_width, has_bg_color, ...
+      }
+    }
+    return false;
+  }
+
+  // Non-numeric scalars are only legal for unknown fields (or `uri`).
+  bool on_other_scalar() {
+    if (skip_depth > 0)
+      return true;
+    return (state == State::kDetection || state == State::kBBox) &&
+           field == Field::kUnknown;
+  }
+
+  // ---------- RapidJSON SAX interface ----------
+
+  bool Null() { return on_other_scalar(); }
+  bool Bool(bool) { return on_other_scalar(); }
+  bool Int(int i) { return on_int(i); }
+  bool Uint(unsigned u) { return on_int(u); }
+  bool Int64(int64_t i) { return on_int(i); }
+  bool Uint64(uint64_t u) {
+    if (u > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+      return on_double(static_cast<double>(u));
+    return on_int(static_cast<int64_t>(u));
+  }
+  bool Double(double d) { return on_double(d); }
+  bool RawNumber(const char *, rapidjson::SizeType, bool) { return false; }
+
+  bool String(const char *str, rapidjson::SizeType len, bool) {
+    if (skip_depth > 0)
+      return true;
+    if (state == State::kDetection && field == Field::kUri) {
+      if (frame->detections.empty())
+        frame->uri.assign(str, len);
+      return true;
+    }
+    return on_other_scalar();
+  }
+
+  bool StartObject() {
+    if (skip_depth > 0) {
+      ++skip_depth;
+      return true;
+    }
+    switch (state) {
+    case State::kStart:
+      state = State::kSources;
+      return true;
+    case State::kDetections:
+      det = Detection{};
+      seen = 0;
+      rejected = false;
+      field = Field::kUnknown;
+      state = State::kDetection;
+      return true;
+    case State::kDetection:
+      if (field == Field::kBBox) {
+        field = Field::kUnknown;
+        state = State::kBBox;
+        return true;
+      }
+      break;
+    case State::kBBox:
+      break;
+    default:
+      return false;
+    }
+    if (field != Field::kUnknown)
+      return false;
+    skip_depth = 1;
+    return true;
+  }
+
+  bool Key(const char *str, rapidjson::SizeType len, bool) {
+    if (skip_depth > 0)
+      return true;
+    switch (state) {
+    case State::kSources: {
+      int32_t source_id = 0;
+      auto [end, ec] = std::from_chars(str, str + len, source_id);
+      if (ec != std::errc() || end != str + len)
+        return false;
+      frame = &arena.acquire();
+      frame->source_id = source_id;
+      state = State::kSourceKey;
+      return true;
+    }
+    case State::kDetection:
+      field = detection_field(str, len);
+      // The frame's uri and frame_num are still read from rejected ones.
+      if (rejected && field != Field::kUri && field != Field::kFrameNum)
+        field = Field::kUnknown;
+      return true;
+    case State::kBBox:
+      field = bbox_field(str, len);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  bool EndObject(rapidjson::SizeType) {
+    if (skip_depth > 0) {
+      --skip_depth;
+      return true;
+    }
+    switch (state) {
+    case State::kSources:
+      state = State::kDone;
+      return true;
+    case State::kBBox:
+      field = Field::kUnknown;
+      state = State::kDetection;
+      return true;
+    case State::kDetection: {
+      state = State::kDetections;
+      if (rejected) {
+        arena.note_filtered(1);
+        return true;
+      }
+      if ((seen & kRequired) != kRequired)
+        return false;
+      auto &detections = frame->detections;
+      if (detections.size() < max_detections) {
+        detections.push_back(det);
+      } else {
+        arena.note_truncated(1);
+      }
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+
+  bool StartArray() {
+    if (skip_depth > 0) {
+      ++skip_depth;
+      return true;
+    }
+    if (state == State::kSourceKey) {
+      state = State::kDetections;
+      return true;
+    }
+    if ((state == State::kDetection || state == State::kBBox) &&
+        field == Field::kUnknown) {
+      skip_depth = 1;
+      return true;
+    }
+    return false;
+  }
+
+  bool EndArray(rapidjson::SizeType) {
+    if (skip_depth > 0) {
+      --skip_depth;
+      return true;
+    }
+    if (state == State::kDetections) {
+      state = State::kSources;
+      return true;
+    }
+    return false;
+  }
+};
+
+} // namespace
+
+JsonDecoder::JsonDecoder(FrameArena &arena)
+    : stack_allocator_(arena.decoder_pool(), arena.decoder_pool_size()),
+      reader_(&stack_allocator_, kStackCapacity) {}
+
+bool JsonDecoder::decode(const char *data, size_t size, FrameArena &arena,
+                         const DetectionFilter *filter) {
+  Handler handler{arena, arena.max_detections(), filter};
+  rapidjson::MemoryStream stream(data, size);
+
+  reader_.Parse<rapidjson::kParseDefaultFlags>(stream, handler);
+
+  if (reader_.HasParseError() || handler.state != State::kDone)
+    return false;
+
+  for (const auto &frame : arena) {
+    arena.add_view(view_of(frame));
+  }
+  return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "analytics/detection_filter.h"
+#include "analytics/frame.h"
+#include "analytics/frame_arena.h"
+#include "include/rapidjson.hpp"
+
+// Schema-directed SAX decoder for `{source_id: [detection, ...]}` payloads.
+//
+// Known fields are written straight into `Frame` / `Detection` while the
+// reader streams through the text; no DOM is built and no field is looked up
+// by name after parsing. Type mismatches (e.g. a string `track_id`) abort the
+// parse instead of tripping RapidJSON asserts.
+//
+// The reader's internal stack lives in the arena's decoder pool and keeps its
+// capacity between messages, so steady-state decoding does not allocate.
+class JsonDecoder {
+public:
+  explicit JsonDecoder(FrameArena &arena);
+
+  // Appends one frame (and its FrameView) per source to `arena`, without
+  // the detections `filter` (if any) rejects. Returns false on malformed
+  // input; the arena's contents are then unspecified and should be
+  // discarded.
+  bool decode(const char *data, size_t size, FrameArena &arena,
+              const DetectionFilter *filter = nullptr);
+
+private:
+  using StackAllocator = rapidjson::MemoryPoolAllocator<>;
+  using Reader =
+      rapidjson::GenericReader<rapidjson::UTF8<>, rapidjson::UTF8<>,
+                               StackAllocator>;
+
+  static constexpr size_t kStackCapacity = 1024;
+
+  StackAllocator stack_allocator_;
+  Reader reader_;
+};
@@ -1,56 +1,148 @@
+#include <algorithm>
 #include <chrono>
+#include <csignal>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 
+#include "analytics/affinity.h"
+#include "analytics/capture.h"
+#include "analytics/consumer.h"
+#include "analytics/event_loop.h"
+#include "analytics/publisher.h"
+#include "analytics/receiver.h"
+#include "analytics/report_tick.h"
+#include "analytics/transport.h"
+#include "analytics/worker_pool.h"
 #include "common/config.h"
-#include "include/rapidjson.hpp"
 #include <zmq.hpp>
 
-// ================= Metrics (Step 2) =================
+// ---------- message sources ----------
+//
+// `pump` calls `on_batch()` for every batch a source yields, and runs the
+// cold-path timers registered on `loop` alongside.
+
+// Live socket: the socket and the timers share one event loop on this
+// thread; it runs until `loop.stop()` (SIGINT/SIGTERM).
+template <typename F>
+void pump(Receiver &receiver, EventLoop &loop, const F &on_batch) {
+  loop.add_socket(receiver.socket(), [&] {
+    if (receiver.poll_batch() > 0)
+      on_batch();
+  });
+  loop.run();
+}
 
-struct NullMetrics {
-  // cppcheck-suppress functionStatic
-  inline void on_frame() {}
-};
+// Capture file: replay drives this thread flat out (or paced), so the timers
+// get a thread of their own.
+template <typename F>
+void pump(Replayer &replayer, EventLoop &loop, const F &on_batch) {
+  std::thread timers([&loop] { loop.run(); });
+  while (replayer.recv_batch() > 0) {
+    on_batch();
+  }
+  loop.stop();
+  timers.join();
+}
 
-struct RealMetrics {
-  uint64_t frames = 0;
-  inline void on_frame() { frames++; }
-};
+// ---------- run modes ----------
+
+// Single thread: (batched) recv, then decode + analytics.
+template <typename Source>
+void run_inline(Source &source, EventLoop &loop, Consumer &consumer) {
+  pump(source, loop, [&] {
+    consumer.metrics().on_batch(source.size());
+    consumer.consume_batch(source.begin(), source.size());
+    consumer.maybe_report();
+  });
+  consumer.print_final_summary();
+  std::cerr << "[SHED] " << consumer.shedder().shed() << " frame(s) total\n";
+}
 
-#ifdef ENABLE_METRICS
-using Metrics = RealMetrics;
-#else
-using Metrics = NullMetrics;
-#endif
+// This thread only receives; decode + analytics run on the pool's workers,
+// each fed by its own SPSC ring. One worker is the pipelined mode; N workers
+// shard sources. A slow decode backs up into a ring (sized in config.toml)
+// before it backs up into the ZMQ queue.
+template <typename Source>
+void run_pool(Source &source, EventLoop &loop, WorkerPool &pool) {
+  pump(source, loop, [&] {
+    for (auto &payload : source) {
+      pool.dispatch(payload);
+    }
+  });
+
+  pool.stop();
+  pool.print_final_summaries();
+  std::cerr << "[RING] receive thread stalled on a full ring "
+            << pool.ring_full() << " time(s)\n";
+  std::cerr << "[SHED] " << pool.shed() << " frame(s) total\n";
+}
 
-// ====================================================
+// ---------- event publisher ----------
 
-void parse_metadata(const zmq::message_t &payload) {
-  rapidjson::Document doc;
+// Null without `[events] publish`. Started before this thread pins itself,
+// so the publisher thread does not inherit its CPU.
+std::unique_ptr<Publisher> start_publisher(const Config &cfg,
+                                           size_t producers) {
+  if (cfg.events.publish.empty())
+    return nullptr;
+  return std::make_unique<Publisher>(cfg, producers);
+}
 
-  doc.Parse(static_cast<const char *>(payload.data()), payload.size());
+// Call once the consumers have stopped.
+void stop_publisher(Publisher *publisher) {
+  if (publisher == nullptr)
+    return;
+  publisher->stop();
+  std::cerr << "[PUBLISH] " << publisher->messages() << " message(s) sent\n";
+}
 
-  if (doc.HasParseError() || !doc.IsObject()) {
+template <typename Source>
+void run(const Config &cfg, Source &source, EventLoop &loop) {
+  std::cout << "Receive thread: " << describe_cpu(cfg.affinity.receive_cpu)
+            << (cfg.affinity.busy_poll ? ", busy-poll" : "") << "\n";
+
+  if (cfg.pipeline.mode == PipelineMode::kInline) {
+    auto publisher = start_publisher(cfg, 1);
+    // Pin first so the consumer's memory is first touched on this node.
+    pin_current_thread(cfg.affinity.receive_cpu);
+    // Allocated once; reused for every message.
+    Consumer consumer(cfg);
+    if (publisher)
+      consumer.set_publish_queue(&publisher->queue(0));
+    run_inline(source, loop, consumer);
+    stop_publisher(publisher.get());
     return;
   }
 
-  // Iterate through the JSON object and print track_id of each detection
-  for (auto it = doc.MemberBegin(); it != doc.MemberEnd(); ++it) {
-    const auto &detections = it->value;
-
-    if (!detections.IsArray())
-      continue;
+  // No point in more workers than sources.
+  size_t workers = 1;
+  if (cfg.pipeline.mode == PipelineMode::kSharded) {
+    workers = static_cast<size_t>(
+        std::max(1, std::min(cfg.pipeline.workers, cfg.analytics.max_sources)));
+  }
+  std::cout << "Workers: " << workers << ", ring capacity "
+            << cfg.pipeline.ring_capacity << "\n";
+
+  // Workers pin themselves; pin this thread only after they are spawned so
+  // unpinned workers do not inherit its mask.
+  auto publisher = start_publisher(cfg, workers);
+  WorkerPool pool(cfg, workers, publisher.get());
+  pin_current_thread(cfg.affinity.receive_cpu);
+  run_pool(source, loop, pool);
+  stop_publisher(publisher.get());
+}
 
-    for (auto &det : detections.GetArray()) {
-      int track_id = det["track_id"].GetInt();
-      int class_id = det["class_id"].GetInt();
+EventLoop *g_loop = nullptr;
+Replayer *g_replayer = nullptr;
 
-      (void)track_id;
-      (void)class_id;
-    }
-  }
+extern "C" void on_stop_signal(int) {
+  if (g_loop != nullptr)
+    g_loop->stop();
+  if (g_replayer != nullptr)
+    g_replayer->stop();
 }
 
 int main(int argc, char **argv) {
@@ -66,56 +158,81 @@ int main(int argc, char **argv) {
   std::cout << "[config]\n";
   std::cout << "  max_sources: " << cfg.analytics.max_sources << "\n";
   std::cout << "  max_detections: " << cfg.analytics.max_detections << "\n";
-  std::cout << "  zmq endpoint: " << cfg.zmq.endpoint << "\n";
-
-  // ---------- zmq init ----------
-  zmq::context_t ctx{1};
-
-  zmq::socket_t socket(ctx, zmq::socket_type::sub);
-
-  socket.set(zmq::sockopt::rcvhwm, cfg.zmq.rcvhwm);
-  socket.set(zmq::sockopt::subscribe, cfg.zmq.subscribe);
-
-  socket.connect(cfg.zmq.endpoint);
-
-  std::cout << "Connected to " << cfg.zmq.endpoint << "\n";
+  std::cout << "  zmq endpoint: " << cfg.zmq.endpoint << " ("
+            << (cfg.zmq.socket_type == SocketType::kPull ? "pull" : "sub")
+            << ", " << (cfg.zmq.bind ? "bind" : "connect") << ")\n";
+  std::cout << "  zmq format: "
+            << (cfg.zmq.format == WireFormat::kBinary ? "binary" : "json")
+            << "\n";
+  std::cout << "  overload policy: "
+            << (cfg.overload.policy == OverloadPolicy::kQueue ? "queue"
+                : cfg.overload.policy == OverloadPolicy::kDropOldest
+                    ? "drop-oldest"
+                    : "conflate-per-source")
+            << "\n";
+
+  // ---------- event loop ----------
+  EventLoop loop;
+  g_loop = &loop;
+  std::signal(SIGINT, on_stop_signal);
+  std::signal(SIGTERM, on_stop_signal);
+
+  // Cold path: consumers pick the request up after their next batch.
+  loop.add_timer(std::chrono::seconds(cfg.analytics.report_interval_sec),
+                 [] { request_report(); });
+  if (!cfg.windows.spans_sec.empty()) {
+    loop.add_timer(std::chrono::seconds(cfg.windows.bucket_sec),
+                   [] { close_window_bucket(); });
+  }
 
-  // ---------- recv test ----------
-  zmq::message_t topic;
-  zmq::message_t payload;
+  // ---------- replay ----------
+  if (cfg.capture.mode == CaptureMode::kReplay) {
+    Replayer replayer(cfg.zmq, cfg.capture);
+    if (!replayer.open())
+      return 1;
+    g_replayer = &replayer;
+    // Payloads are decoded in the format they were captured in.
+    cfg.zmq.format = replayer.format();
+    std::cout << "Replaying " << replayer.records() << " message(s) from "
+              << cfg.capture.path << " at ";
+    if (cfg.capture.speed > 0.0) {
+      std::cout << cfg.capture.speed << "x\n";
+    } else {
+      std::cout << "max speed\n";
+    }
 
-  Metrics metrics;
-#ifdef ENABLE_METRICS
-  auto start = std::chrono::steady_clock::now();
-  auto last_report = start;
-#endif
+    auto start = std::chrono::steady_clock::now();
+    run(cfg, replayer, loop);
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    std::cerr << "[REPLAY] " << replayer.replayed() << " message(s) in "
+              << elapsed << " s ("
+              << (elapsed > 0.0 ? replayer.replayed() / elapsed : 0.0)
+              << " msg/s)\n";
+    g_replayer = nullptr;
+    return 0;
+  }
 
-  while (true) {
-    // I/O blocking recv
-    if (!socket.recv(topic, zmq::recv_flags::none))
-      break;
-    if (!socket.recv(payload, zmq::recv_flags::none))
-      break;
+  // ---------- zmq init ----------
+  zmq::context_t ctx{1};
 
-    // ---------- hot path ----------
-    parse_metadata(payload);
-    metrics.on_frame();
-    // ------- end hot path ---------
+  zmq::socket_t socket = open_consumer_socket(ctx, cfg.zmq);
 
-#ifdef ENABLE_METRICS
-    // ---------- cold path ----------
-    auto now = std::chrono::steady_clock::now();
-    if (now - last_report >= std::chrono::seconds(5)) {
-      auto elapsed =
-          std::chrono::duration_cast<std::chrono::milliseconds>(now - start)
-              .count();
-      double fps = metrics.frames * 1000.0 / elapsed;
+  Receiver receiver(socket, cfg.zmq);
 
-      std::cerr << "[FPS] " << fps << "\n";
-      last_report = now;
+  CaptureWriter capture;
+  if (cfg.capture.mode == CaptureMode::kRecord) {
+    if (!capture.open(cfg.capture.path,
+                      static_cast<size_t>(cfg.capture.max_mb) << 20,
+                      cfg.zmq.format)) {
+      return 1;
     }
-    // ------- end cold path ---------
-#endif
+    receiver.set_capture(&capture);
+    std::cout << "Recording to " << cfg.capture.path << "\n";
   }
+
+  loop.set_busy_poll(cfg.affinity.busy_poll);
+  run(cfg, receiver, loop);
   return 0;
 }
@@ -0,0 +1,127 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+// ================= Metrics (Step 2) =================
+//
+// Compile-time policy: `NullMetrics` compiles to nothing, `RealMetrics` is
+// selected with ENABLE_METRICS. Each decode thread owns one instance.
+// `report` is called by the owning Consumer when a report is due (see
+// report_tick.h), never from the per-message path.
+
+struct NullMetrics {
+  // cppcheck-suppress functionStatic
+  inline void set_worker(int) {}
+  // cppcheck-suppress functionStatic
+  inline void on_frame() {}
+  // cppcheck-suppress functionStatic
+  inline void on_ring(size_t) {}
+  // cppcheck-suppress functionStatic
+  inline void on_batch(size_t) {}
+  // cppcheck-suppress functionStatic
+  inline void on_shed(size_t) {}
+  // cppcheck-suppress functionStatic
+  inline void record_cache_hit() {}
+  // cppcheck-suppress functionStatic
+  inline void record_cache_miss() {}
+  // cppcheck-suppress functionStatic
+  inline void report() {}
+};
+
+struct RealMetrics {
+  int worker = -1; // set in sharded/pipelined mode to tag report lines
+  uint64_t frames = 0;
+
+  // Ring occupancy seen by the consumer at each pop (pipelined mode).
+  uint64_t ring_samples = 0;
+  uint64_t ring_sum = 0;
+  size_t ring_max = 0;
+
+  // Messages per receive batch (inline mode).
+  uint64_t batches = 0;
+  uint64_t batched_messages = 0;
+
+  // Frames dropped by the overload policy.
+  uint64_t shed = 0;
+
+  // Track-table lookups (same meaning as PerformanceMetrics in analyze.py):
+  // a hit is a detection of an already known track.
+  uint64_t cache_hits = 0;
+  uint64_t cache_misses = 0;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  inline void set_worker(int id) { worker = id; }
+
+  inline void on_frame() { frames++; }
+
+  inline void on_ring(size_t occupancy) {
+    ring_samples++;
+    ring_sum += occupancy;
+    if (occupancy > ring_max)
+      ring_max = occupancy;
+  }
+
+  inline void on_batch(size_t n) {
+    batches++;
+    batched_messages += n;
+  }
+
+  inline void on_shed(size_t n) { shed += n; }
+
+  inline void record_cache_hit() { cache_hits++; }
+  inline void record_cache_miss() { cache_misses++; }
+
+  // ---------- cold path ----------
+  void report() {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - start)
+            .count();
+    double fps = frames * 1000.0 / (elapsed > 0 ? elapsed : 1);
+
+    std::cerr << "[FPS]";
+    if (worker >= 0)
+      std::cerr << " w" << worker;
+    std::cerr << " " << fps << "\n";
+    if (ring_samples > 0) {
+      std::cerr << "[RING]";
+      if (worker >= 0)
+        std::cerr << " w" << worker;
+      std::cerr << " avg " << static_cast<double>(ring_sum) / ring_samples
+                << " max " << ring_max << "\n";
+      ring_samples = 0;
+      ring_sum = 0;
+      ring_max = 0;
+    }
+    if (batches > 0) {
+      std::cerr << "[BATCH] avg "
+                << static_cast<double>(batched_messages) / batches << "\n";
+      batches = 0;
+      batched_messages = 0;
+    }
+    if (shed > 0) {
+      std::cerr << "[SHED]";
+      if (worker >= 0)
+        std::cerr << " w" << worker;
+      std::cerr << " " << shed << " frame(s)\n";
+      shed = 0;
+    }
+    if (uint64_t lookups = cache_hits + cache_misses) {
+      std::cerr << "[CACHE]";
+      if (worker >= 0)
+        std::cerr << " w" << worker;
+      std::cerr << " hits " << cache_hits << " misses " << cache_misses
+                << " hit rate " << 100.0 * cache_hits / lookups << "%\n";
+    }
+  }
+};
+
+#ifdef ENABLE_METRICS
+using Metrics = RealMetrics;
+#else
+using Metrics = NullMetrics;
+#endif
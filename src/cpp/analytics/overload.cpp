@@ -0,0 +1,56 @@
+#include "analytics/overload.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "analytics/wire_format.h"
+
+Shedder::Shedder(const Config &cfg, size_t capacity)
+    : policy_(cfg.overload.policy), format_(cfg.zmq.format),
+      max_pending_(static_cast<size_t>(std::max(1, cfg.overload.max_pending))),
+      keep_(capacity) {
+  seen_sources_.reserve(capacity);
+}
+
+size_t Shedder::apply(zmq::message_t *msgs, size_t n) {
+  if (policy_ == OverloadPolicy::kQueue || n <= 1)
+    return n;
+
+  if (policy_ == OverloadPolicy::kDropOldest) {
+    if (n <= max_pending_)
+      return n;
+    size_t drop = n - max_pending_;
+    for (size_t i = 0; i < max_pending_; i++) {
+      msgs[i] = std::move(msgs[drop + i]);
+    }
+    shed_ += drop;
+    return max_pending_;
+  }
+
+  // conflate-per-source: walk newest to oldest, keep the first of each source.
+  seen_sources_.clear();
+  for (size_t i = n; i-- > 0;) {
+    int32_t source_id = 0;
+    if (!peek_source_id(format_, static_cast<const char *>(msgs[i].data()),
+                        msgs[i].size(), source_id)) {
+      keep_[i] = 1; // let the decoder reject it
+      continue;
+    }
+    bool seen = std::find(seen_sources_.begin(), seen_sources_.end(),
+                          source_id) != seen_sources_.end();
+    keep_[i] = seen ? 0 : 1;
+    if (!seen)
+      seen_sources_.push_back(source_id);
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (!keep_[i])
+      continue;
+    if (kept != i)
+      msgs[kept] = std::move(msgs[i]);
+    kept++;
+  }
+  shed_ += n - kept;
+  return kept;
+}
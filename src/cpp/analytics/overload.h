@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+#include <zmq.hpp>
+
+// Load shedding over a batch of pending payloads (`[overload]` in
+// config.toml). Applied to whatever a thread has drained at once — the
+// receive batch in inline mode, a worker's ring in pool modes — so when the
+// consumer keeps up there is nothing to shed.
+//
+//   queue                keep everything (no shedding)
+//   conflate-per-source  keep only the newest pending frame of each source
+//   drop-oldest          keep only the newest `max_pending` frames
+//
+// Survivors keep their relative order, so per-source ordering holds.
+class Shedder {
+public:
+  // `capacity` is the largest batch `apply` will be given.
+  Shedder(const Config &cfg, size_t capacity);
+
+  // Compacts the kept payloads to the front of `msgs[0, n)` and returns how
+  // many were kept.
+  size_t apply(zmq::message_t *msgs, size_t n);
+
+  OverloadPolicy policy() const { return policy_; }
+
+  // Frames shed since startup.
+  uint64_t shed() const { return shed_; }
+
+private:
+  OverloadPolicy policy_;
+  WireFormat format_;
+  size_t max_pending_;
+  uint64_t shed_ = 0;
+
+  // Preallocated per-batch scratch.
+  std::vector<uint8_t> keep_;
+  std::vector<int32_t> seen_sources_;
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "analytics/detection_filter.h"
+#include "analytics/frame_arena.h"
+#include "analytics/frame_columns.h"
+#include "analytics/json_decoder.h"
+#include "analytics/source_index.h"
+#include "analytics/wire_format.h"
+#include "common/config.h"
+
+// ================= Pipeline =================
+//
+// Compile-time composition of the per-message stages, in the style of the
+// Metrics policy: every stage is a type fixed where the pipeline is declared
+// (see consumer.h), and the pipeline calls it directly, so stage calls
+// inline into one chain with no virtual dispatch or stage registry. A stage
+// left out of the type list is not compiled in; a NullFilter compiles to
+// nothing.
+//
+// Stage policies:
+//
+//   Decoder     Decoder(const Config &, FrameArena &);
+//               bool decode(const char *data, size_t size, FrameArena &,
+//                           const Filter &);
+//   Filter      explicit Filter(const Config &);
+//               bool active() const;
+//   Aggregator  explicit Aggregator(const Config &);
+//               bool enabled() const;
+//               void add_frame(size_t slot, const FrameColumns &);
+//               void print_interval(int worker, const SourceIndex &);
+//               optional: void begin_message();
+//               optional: void print_final(int worker, const SourceIndex &);
+//
+// The optional hooks are found by a member check and called only on stages
+// that define them, so any aggregator can be added to or left out of the
+// list; code that needs one stage looks it up with `find<Stage>()`, which is
+// null when the stage is not compiled in.
+//
+// The filter is pushed down into the decoder, which drops rejected
+// detections while reading them (see detection_filter.h). The Consumer
+// decodes a payload, tracks each frame (per-source state, zones, lines) and
+// hands the frame's columns to the aggregators, which run in list order.
+
+// Keeps every detection.
+struct NullFilter {
+  explicit NullFilter(const Config &) {}
+  // cppcheck-suppress functionStatic
+  bool active() const { return false; }
+};
+
+// Decodes the configured `[zmq] format`.
+class WireDecoder {
+public:
+  WireDecoder(const Config &cfg, FrameArena &arena)
+      : format_(cfg.zmq.format), json_(arena) {}
+
+  bool decode(const char *data, size_t size, FrameArena &arena,
+              const DetectionFilter &filter) {
+    return decode_format(data, size, arena,
+                         filter.active() ? &filter : nullptr);
+  }
+
+  bool decode(const char *data, size_t size, FrameArena &arena,
+              const NullFilter &) {
+    return decode_format(data, size, arena, nullptr);
+  }
+
+private:
+  bool decode_format(const char *data, size_t size, FrameArena &arena,
+                     const DetectionFilter *filter) {
+    return format_ == WireFormat::kBinary
+               ? decode_binary_frame(data, size, arena, filter)
+               : json_.decode(data, size, arena, filter);
+  }
+
+  WireFormat format_;
+  JsonDecoder json_;
+};
+
+// Member checks for the optional aggregator hooks.
+template <typename Stage>
+using BeginMessageCall = decltype(std::declval<Stage &>().begin_message());
+template <typename Stage>
+using PrintFinalCall = decltype(std::declval<const Stage &>().print_final(
+    0, std::declval<const SourceIndex &>()));
+
+template <typename Stage, typename = void>
+struct HasBeginMessage : std::false_type {};
+template <typename Stage>
+struct HasBeginMessage<Stage, std::void_t<BeginMessageCall<Stage>>>
+    : std::true_type {};
+
+template <typename Stage, typename = void>
+struct HasPrintFinal : std::false_type {};
+template <typename Stage>
+struct HasPrintFinal<Stage, std::void_t<PrintFinalCall<Stage>>>
+    : std::true_type {};
+
+template <typename Decoder, typename Filter, typename... Aggregators>
+class Pipeline {
+public:
+  Pipeline(const Config &cfg, FrameArena &arena)
+      : decoder_(cfg, arena), filter_(cfg),
+        stages_(config_for<Aggregators>(cfg)...) {}
+
+  // ---------- hot path ----------
+
+  // Decodes one payload into `arena`, without the detections the filter
+  // rejects (see the Decoder policy).
+  bool decode(const char *data, size_t size, FrameArena &arena) {
+    return decoder_.decode(data, size, arena, filter_);
+  }
+
+  // Start of a payload, before its frames.
+  void begin_message() {
+    std::apply([](auto &...stage) { (begin_stage(stage), ...); }, stages_);
+  }
+
+  // Runs every enabled aggregator over one frame of source slot `slot`.
+  void add_frame(size_t slot, const FrameColumns &frame) {
+    std::apply([&](auto &...stage) { (add_to(stage, slot, frame), ...); },
+               stages_);
+  }
+
+  // ---------- cold path ----------
+
+  // True if the filter may drop detections.
+  bool filtering() const { return filter_.active(); }
+
+  void print_interval(int worker, const SourceIndex &sources) {
+    std::apply(
+        [&](auto &...stage) { (print_stage(stage, worker, sources), ...); },
+        stages_);
+  }
+
+  void print_final(int worker, const SourceIndex &sources) const {
+    std::apply(
+        [&](const auto &...stage) {
+          (final_stage(stage, worker, sources), ...);
+        },
+        stages_);
+  }
+
+  // True if `Stage` is in the aggregator list.
+  template <typename Stage> static constexpr bool has() {
+    return (std::is_same_v<Stage, Aggregators> || ...);
+  }
+
+  // The `Stage` aggregator, or null if it is not in the list.
+  template <typename Stage> const Stage *find() const {
+    if constexpr (has<Stage>())
+      return &std::get<Stage>(stages_);
+    else
+      return nullptr;
+  }
+
+private:
+  // Constructs every aggregator in place from the same config.
+  template <typename Stage> static const Config &config_for(const Config &c) {
+    return c;
+  }
+
+  template <typename Stage>
+  static void add_to(Stage &stage, size_t slot, const FrameColumns &frame) {
+    if (stage.enabled())
+      stage.add_frame(slot, frame);
+  }
+
+  template <typename Stage> static void begin_stage(Stage &stage) {
+    if constexpr (HasBeginMessage<Stage>::value) {
+      if (stage.enabled())
+        stage.begin_message();
+    }
+  }
+
+  template <typename Stage>
+  static void final_stage(const Stage &stage, int worker,
+                          const SourceIndex &sources) {
+    if constexpr (HasPrintFinal<Stage>::value) {
+      if (stage.enabled())
+        stage.print_final(worker, sources);
+    }
+  }
+
+  template <typename Stage>
+  static void print_stage(Stage &stage, int worker,
+                          const SourceIndex &sources) {
+    if (stage.enabled())
+      stage.print_interval(worker, sources);
+  }
+
+  Decoder decoder_;
+  Filter filter_;
+  std::tuple<Aggregators...> stages_;
+};
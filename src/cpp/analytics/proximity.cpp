@@ -0,0 +1,195 @@
+#include "analytics/proximity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// Pairs kept per detection; a denser frame still counts every pair.
+constexpr size_t kPairsPerDetection = 8;
+
+// Anchors are clamped to this many pixels either way before being binned.
+constexpr float kMaxCoordinate = 1e9f;
+
+// Cells searched from a point: its own (later points only) and the four
+// after it in scan order; the other four neighbours find it from their side.
+constexpr int32_t kNeighbours[5][2] = {{0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+} // namespace
+
+Proximity::Proximity(const Config &cfg)
+    : distance_(cfg.proximity.distance),
+      cell_scale_(distance_ > 0.0f ? 1.0f / distance_ : 0.0f),
+      crowd_size_(static_cast<uint32_t>(cfg.proximity.crowd_size)),
+      all_classes_(cfg.proximity.classes.empty()) {
+  for (int c : cfg.proximity.classes) {
+    if (c < 256)
+      class_mask_[c / 64] |= uint64_t{1} << (c % 64);
+  }
+
+  auto n = static_cast<size_t>(std::max(1, cfg.analytics.max_detections));
+  // At least two buckets per point keeps chains short.
+  unsigned bits = 6;
+  while ((size_t{1} << bits) < 2 * n)
+    bits++;
+  buckets_ = size_t{1} << bits;
+  shift_ = 32 - bits;
+
+  if (!enabled())
+    return;
+  size_t column = round_up_to_line<uint32_t>(n);
+  member_ = make_aligned_array<uint32_t>(column);
+  x_ = make_aligned_array<float>(column);
+  y_ = make_aligned_array<float>(column);
+  cell_x_ = make_aligned_array<int32_t>(column);
+  cell_y_ = make_aligned_array<int32_t>(column);
+  bucket_ = make_aligned_array<uint32_t>(column);
+  order_ = make_aligned_array<uint32_t>(column);
+  start_ = make_aligned_array<uint32_t>(buckets_ + 1);
+  parent_ = make_aligned_array<uint32_t>(column);
+  size_ = make_aligned_array<uint32_t>(column);
+  pairs_.resize(kPairsPerDetection * n);
+  stats_.resize(static_cast<size_t>(std::max(1, cfg.analytics.max_sources)));
+}
+
+void Proximity::add_frame(size_t slot, const FrameColumns &frame) {
+  const int32_t *cls = frame.class_id();
+  const float *ax = frame.anchor_x();
+  const float *ay = frame.anchor_y();
+  uint32_t *member = member_.get();
+  float *x = x_.get();
+  float *y = y_.get();
+
+  // Considered detections, compacted without branches.
+  size_t n = 0;
+  for (size_t i = 0; i < frame.size(); i++) {
+    member[n] = static_cast<uint32_t>(i);
+    x[n] = ax[i];
+    y[n] = ay[i];
+    n += counts(cls[i]);
+  }
+
+  // Cell of every point: floor(coordinate / distance).
+  int32_t *cell_x = cell_x_.get();
+  int32_t *cell_y = cell_y_.get();
+  uint32_t *bucket = bucket_.get();
+  float scale = cell_scale_;
+  for (size_t i = 0; i < n; i++) {
+    float fx = std::min(kMaxCoordinate, std::max(-kMaxCoordinate, x[i])) *
+               scale;
+    float fy = std::min(kMaxCoordinate, std::max(-kMaxCoordinate, y[i])) *
+               scale;
+    auto cx = static_cast<int32_t>(fx);
+    auto cy = static_cast<int32_t>(fy);
+    cx -= fx < static_cast<float>(cx); // truncation -> floor
+    cy -= fy < static_cast<float>(cy);
+    cell_x[i] = cx;
+    cell_y[i] = cy;
+    bucket[i] = bucket_of(cx, cy);
+  }
+
+  // Counting sort of the points by bucket.
+  uint32_t *start = start_.get();
+  uint32_t *order = order_.get();
+  std::memset(start, 0, (buckets_ + 1) * sizeof(uint32_t));
+  for (size_t i = 0; i < n; i++) {
+    start[bucket[i] + 1]++;
+  }
+  for (size_t b = 0; b < buckets_; b++) {
+    start[b + 1] += start[b];
+  }
+  for (size_t i = 0; i < n; i++) {
+    order[start[bucket[i]]++] = static_cast<uint32_t>(i);
+  }
+  // start[b] now holds the end of bucket b; shift back to the beginning.
+  std::memmove(start + 1, start, buckets_ * sizeof(uint32_t));
+  start[0] = 0;
+
+  uint32_t *parent = parent_.get();
+  for (size_t i = 0; i < n; i++) {
+    parent[i] = static_cast<uint32_t>(i);
+  }
+
+  float limit = distance_ * distance_;
+  uint32_t pairs = 0;
+  size_t stored = 0;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t o = 0; o < 5; o++) {
+      int32_t cx = cell_x[i] + kNeighbours[o][0];
+      int32_t cy = cell_y[i] + kNeighbours[o][1];
+      uint32_t b = bucket_of(cx, cy);
+      bool own = o == 0;
+      for (uint32_t k = start[b]; k < start[b + 1]; k++) {
+        uint32_t j = order[k];
+        // Skips points of other cells hashed to the same bucket.
+        if ((own && j <= i) || cell_x[j] != cx || cell_y[j] != cy)
+          continue;
+        float ex = x[j] - x[i];
+        float ey = y[j] - y[i];
+        float d2 = ex * ex + ey * ey;
+        if (!(d2 < limit))
+          continue;
+        pairs++;
+        link(static_cast<uint32_t>(i), j);
+        if (stored < pairs_.size()) {
+          uint32_t a = std::min(member[i], member[j]);
+          uint32_t z = std::max(member[i], member[j]);
+          pairs_[stored++] = ProximityPair{a, z, std::sqrt(d2)};
+        }
+      }
+    }
+  }
+  stored_ = stored;
+  pairs_now_ = pairs;
+  find_crowds(n);
+
+  SourceStats &s = stats_[slot];
+  s.pairs = pairs_now_;
+  s.crowds = crowds_now_;
+  s.largest = largest_now_;
+  s.pair_sum += pairs_now_;
+  s.crowd_sum += crowds_now_;
+  s.pair_peak = std::max(s.pair_peak, pairs_now_);
+  s.largest_peak = std::max(s.largest_peak, largest_now_);
+  s.frames++;
+}
+
+void Proximity::find_crowds(size_t n) {
+  uint32_t *size = size_.get();
+  std::memset(size, 0, n * sizeof(uint32_t));
+  for (size_t i = 0; i < n; i++) {
+    size[root(static_cast<uint32_t>(i))]++;
+  }
+  uint32_t crowds = 0;
+  uint32_t largest = 0;
+  for (size_t i = 0; i < n; i++) {
+    crowds += size[i] >= crowd_size_;
+    largest = std::max(largest, size[i]);
+  }
+  crowds_now_ = crowds;
+  largest_now_ = largest >= crowd_size_ ? largest : 0;
+}
+
+void Proximity::print_interval(int worker, const SourceIndex &sources) {
+  if (!enabled())
+    return;
+  for (size_t slot = 0; slot < sources.size(); slot++) {
+    SourceStats &s = stats_[slot];
+    double frames = s.frames > 0 ? static_cast<double>(s.frames) : 1.0;
+    std::cerr << "[PROXIMITY]";
+    if (worker >= 0)
+      std::cerr << " w" << worker;
+    std::cerr << " source " << sources.id(slot) << ": pairs now " << s.pairs
+              << ", avg " << s.pair_sum / frames << ", peak " << s.pair_peak
+              << "; crowds now " << s.crowds << " (largest " << s.largest
+              << "), avg " << s.crowd_sum / frames << ", largest seen "
+              << s.largest_peak << "\n";
+    s.pair_sum = 0;
+    s.crowd_sum = 0;
+    s.pair_peak = 0;
+    s.largest_peak = 0;
+    s.frames = 0;
+  }
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "analytics/aligned.h"
+#include "analytics/frame_columns.h"
+#include "analytics/source_index.h"
+#include "common/config.h"
+
+// ================= Proximity =================
+//
+// Pairs of detections closer than `[proximity] distance` (bbox
+// bottom-centres, i.e. on the ground), and crowds: groups of at least
+// `crowd_size` detections chained by such pairs.
+//
+// Each frame the anchors are dropped into a uniform grid of cells one
+// distance wide, hashed into a fixed bucket table and counting-sorted by
+// bucket. A close pair then lies in the same or a neighbouring cell, so each
+// detection is compared with the few points of its own cell and the four
+// cells after it in scan order (the other four find it from their side)
+// instead of every other detection. Points carry their cell, which filters
+// bucket collisions. Crowds are the components of a union-find
+// built from the pairs. All tables are sized for max_detections at startup.
+
+// One close pair of the last added frame: detection indices (a < b)
+// and the distance between their anchors.
+struct ProximityPair {
+  uint32_t a;
+  uint32_t b;
+  float distance;
+};
+
+class Proximity {
+public:
+  explicit Proximity(const Config &cfg);
+
+  bool enabled() const { return distance_ > 0.0f; }
+
+  // ---------- hot path ----------
+
+  // Finds the close pairs and crowds of `frame`, from source slot `slot`.
+  void add_frame(size_t slot, const FrameColumns &frame);
+
+  // Pairs of the last frame. At most 8 per detection are kept; `pairs()`
+  // counts all of them.
+  const ProximityPair *begin() const { return pairs_.data(); }
+  const ProximityPair *end() const { return pairs_.data() + stored_; }
+  uint32_t pairs() const { return pairs_now_; }
+
+  // Crowds of the last frame and the size of the largest.
+  uint32_t crowds() const { return crowds_now_; }
+  uint32_t largest_crowd() const { return largest_now_; }
+
+  // ---------- cold path ----------
+
+  // Prints pairs and crowds per source since the last call.
+  void print_interval(int worker, const SourceIndex &sources);
+
+private:
+  struct SourceStats {
+    uint32_t pairs = 0; // last frame
+    uint32_t crowds = 0;
+    uint32_t largest = 0;
+    uint64_t pair_sum = 0; // since the last print
+    uint64_t crowd_sum = 0;
+    uint32_t pair_peak = 0;
+    uint32_t largest_peak = 0;
+    uint64_t frames = 0;
+  };
+
+  bool counts(int32_t cls) const {
+    if (all_classes_)
+      return true;
+    auto c = static_cast<uint32_t>(cls);
+    return c < 256 && ((class_mask_[c / 64] >> (c % 64)) & 1);
+  }
+
+  uint32_t bucket_of(int32_t cx, int32_t cy) const {
+    return (static_cast<uint32_t>(cx) * 0x9e3779b1u ^
+            static_cast<uint32_t>(cy) * 0x85ebca77u) >>
+           shift_;
+  }
+
+  uint32_t root(uint32_t i) {
+    while (parent_[i] != i) {
+      parent_[i] = parent_[parent_[i]]; // path halving
+      i = parent_[i];
+    }
+    return i;
+  }
+
+  void link(uint32_t a, uint32_t b) {
+    a = root(a);
+    b = root(b);
+    if (a != b)
+      parent_[a < b ? b : a] = a < b ? a : b;
+  }
+
+  void find_crowds(size_t n);
+
+  float distance_;
+  float cell_scale_; // cells per pixel
+  uint32_t crowd_size_;
+  uint64_t class_mask_[4] = {}; // classes considered, bit per id < 256
+  bool all_classes_;
+
+  unsigned shift_; // 32 - log2(buckets)
+  size_t buckets_;
+
+  // Per-point scratch for the considered detections, in frame order.
+  AlignedArray<uint32_t> member_; // detection index
+  AlignedArray<float> x_;
+  AlignedArray<float> y_;
+  AlignedArray<int32_t> cell_x_;
+  AlignedArray<int32_t> cell_y_;
+  AlignedArray<uint32_t> bucket_;
+  AlignedArray<uint32_t> order_;  // points sorted by bucket
+  AlignedArray<uint32_t> start_;  // buckets + 1 offsets into order_
+  AlignedArray<uint32_t> parent_; // union-find
+  AlignedArray<uint32_t> size_;   // component sizes
+
+  std::vector<ProximityPair> pairs_;
+  size_t stored_ = 0;
+  uint32_t pairs_now_ = 0;
+  uint32_t crowds_now_ = 0;
+  uint32_t largest_now_ = 0;
+
+  std::vector<SourceStats> stats_; // by source slot
+};
@@ -0,0 +1,200 @@
+#include "analytics/publisher.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "analytics/transport.h"
+
+namespace {
+
+// Longest idle sleep: bounds the delay a record waits for the thread.
+constexpr std::chrono::milliseconds kIdleSleep{1};
+
+const char *event_type_name(EventType type) {
+  switch (type) {
+  case EventType::kLineCrossing:
+    return "line_crossing";
+  case EventType::kZoneEnter:
+    return "zone_enter";
+  case EventType::kZoneExit:
+    return "zone_exit";
+  case EventType::kLoitering:
+    return "loitering";
+  case EventType::kTrackEnd:
+    return "track_end";
+  case EventType::kRule:
+    return "rule";
+  }
+  return "unknown";
+}
+
+const char *snapshot_type_name(SnapshotType type) {
+  return type == SnapshotType::kTracks ? "tracks" : "zone";
+}
+
+template <typename Record>
+void append_binary(std::string &out, uint32_t magic,
+                   const std::vector<Record> &records) {
+  PublishHeader header{magic, kPublishVersion,
+                       static_cast<uint16_t>(sizeof(Record)),
+                       static_cast<uint32_t>(records.size())};
+  out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.append(reinterpret_cast<const char *>(records.data()),
+             records.size() * sizeof(Record));
+}
+
+} // namespace
+
+Publisher::Publisher(const Config &cfg, size_t producers)
+    : socket_(open_publisher_socket(ctx_, cfg.events)),
+      format_(cfg.events.publish_format),
+      interval_(cfg.events.publish_interval_ms) {
+  if (producers == 0)
+    producers = 1;
+
+  auto capacity = static_cast<size_t>(cfg.events.publish_queue);
+  for (size_t i = 0; i < producers; i++) {
+    queues_.push_back(std::make_unique<PublishQueue>(capacity));
+    events_.emplace_back();
+    events_.back().reserve(capacity);
+    snapshots_.emplace_back();
+  }
+  out_.reserve(sizeof(PublishHeader) + capacity * sizeof(AnalyticsEvent));
+
+  thread_ = std::thread([this] { run(); });
+}
+
+Publisher::~Publisher() { stop(); }
+
+void Publisher::stop() {
+  stopping_.store(true, std::memory_order_release);
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void Publisher::run() {
+  auto next_flush = std::chrono::steady_clock::now() + interval_;
+  PublishRecord record;
+
+  while (true) {
+    // Read before draining: once set, the consumers have stopped pushing.
+    bool stopping = stopping_.load(std::memory_order_acquire);
+    size_t popped = 0;
+    for (size_t q = 0; q < queues_.size(); q++) {
+      while (queues_[q]->try_pop(record)) {
+        add(q, record);
+        popped++;
+      }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (interval_.count() > 0 && now >= next_flush) {
+      flush_events(events_[0]);
+      next_flush = now + interval_;
+    }
+
+    if (popped > 0)
+      continue;
+    if (stopping)
+      break;
+    // Unpinned cold path: sleep rather than spin, so an idle publisher
+    // leaves the cores to the receive and worker threads.
+    auto wake = now + kIdleSleep;
+    if (interval_.count() > 0)
+      wake = std::min(wake, next_flush);
+    std::this_thread::sleep_until(wake);
+  }
+
+  // Whatever is left, e.g. events whose end marker found a full queue.
+  for (auto &events : events_) {
+    flush_events(events);
+  }
+}
+
+void Publisher::add(size_t producer, const PublishRecord &record) {
+  switch (record.kind) {
+  case PublishRecord::Kind::kEvent:
+    events_[interval_.count() > 0 ? 0 : producer].push_back(record.event);
+    break;
+  case PublishRecord::Kind::kEndOfMessage:
+    if (interval_.count() == 0)
+      flush_events(events_[producer]);
+    break;
+  case PublishRecord::Kind::kSnapshot:
+    snapshots_[producer].push_back(record.snapshot);
+    break;
+  case PublishRecord::Kind::kEndOfSnapshot:
+    flush_snapshot(snapshots_[producer]);
+    break;
+  }
+}
+
+void Publisher::flush_events(std::vector<AnalyticsEvent> &events) {
+  if (events.empty())
+    return;
+  encode(events);
+  send("events");
+  events.clear();
+}
+
+void Publisher::flush_snapshot(std::vector<SnapshotRecord> &snapshot) {
+  if (snapshot.empty())
+    return;
+  encode(snapshot);
+  send("snapshot");
+  snapshot.clear();
+}
+
+void Publisher::send(const char *topic) {
+  // PUB never blocks: past a subscriber's high-water mark ZMQ drops for it.
+  socket_.send(zmq::buffer(topic, std::strlen(topic)),
+               zmq::send_flags::sndmore | zmq::send_flags::dontwait);
+  socket_.send(zmq::buffer(out_), zmq::send_flags::dontwait);
+  messages_++;
+}
+
+void Publisher::encode(const std::vector<AnalyticsEvent> &events) {
+  out_.clear();
+  if (format_ == WireFormat::kBinary) {
+    append_binary(out_, kEventsMagic, events);
+    return;
+  }
+
+  out_ += "{\"events\": [";
+  char buf[256];
+  for (size_t i = 0; i < events.size(); i++) {
+    const AnalyticsEvent &e = events[i];
+    int n = std::snprintf(
+        buf, sizeof(buf),
+        "%s{\"type\": \"%s\", \"source_id\": %d, \"frame_num\": %d, "
+        "\"track_id\": %d, \"class_id\": %d, \"index\": %u, "
+        "\"direction\": %d, \"value\": %d}",
+        i > 0 ? ", " : "", event_type_name(e.type), e.source_id, e.frame_num,
+        e.track_id, e.class_id, static_cast<unsigned>(e.index), e.direction,
+        e.value);
+    out_.append(buf, static_cast<size_t>(n));
+  }
+  out_ += "]}";
+}
+
+void Publisher::encode(const std::vector<SnapshotRecord> &snapshot) {
+  out_.clear();
+  if (format_ == WireFormat::kBinary) {
+    append_binary(out_, kSnapshotMagic, snapshot);
+    return;
+  }
+
+  out_ += "{\"snapshot\": [";
+  char buf[128];
+  for (size_t i = 0; i < snapshot.size(); i++) {
+    const SnapshotRecord &r = snapshot[i];
+    int n = std::snprintf(buf, sizeof(buf),
+                          "%s{\"type\": \"%s\", \"source_id\": %d, "
+                          "\"index\": %u, \"value\": %u}",
+                          i > 0 ? ", " : "", snapshot_type_name(r.type),
+                          r.source_id, static_cast<unsigned>(r.index), r.value);
+    out_.append(buf, static_cast<size_t>(n));
+  }
+  out_ += "]}";
+}
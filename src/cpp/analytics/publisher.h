@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analytics/events.h"
+#include "analytics/spsc_ring.h"
+#include "common/config.h"
+#include <zmq.hpp>
+
+// ================= Event publisher =================
+//
+// Downstream output: analytics events and periodic aggregate snapshots on a
+// PUB socket bound to `[events] publish`, as multipart `(topic, payload)`
+// messages with topic "events" or "snapshot".
+//
+// Each consumer thread owns one PublishQueue, a lock-free SPSC ring of
+// fixed-size records, and only ever try-pushes into it: a full queue drops
+// the record (counted by the consumer), so neither the publisher thread nor
+// a slow subscriber can stall ingest. The publisher thread drains every
+// queue and coalesces events into one message per consumed payload, or per
+// `publish_interval_ms` across all queues; each report's snapshot is one
+// message per consumer thread.
+//
+// Binary payloads (`publish_format = "binary"`), host byte order like the
+// wire format:
+//
+//   PublishHeader                   12 bytes
+//   AnalyticsEvent[count]           24 bytes each   (topic "events")
+//   SnapshotRecord[count]           12 bytes each   (topic "snapshot")
+//
+// JSON payloads are `{"events": [...]}` / `{"snapshot": [...]}`, one object
+// per record with the same fields. Indices are the zone / tripwire / rule
+// within the source, in config order.
+
+enum class SnapshotType : uint8_t {
+  kTracks, // value = tracks in the source's track table
+  kZone,   // index = zone, value = detections inside now
+};
+
+struct SnapshotRecord {
+  SnapshotType type;
+  uint8_t reserved;
+  uint16_t index;
+  int32_t source_id;
+  uint32_t value;
+};
+
+struct PublishHeader {
+  uint32_t magic; // kEventsMagic / kSnapshotMagic
+  uint16_t version;
+  uint16_t record_size;
+  uint32_t count;
+};
+
+constexpr uint32_t kEventsMagic = 0x54564559;   // "YEVT"
+constexpr uint32_t kSnapshotMagic = 0x504e5359; // "YSNP"
+constexpr uint16_t kPublishVersion = 1;
+
+static_assert(sizeof(AnalyticsEvent) == 24, "AnalyticsEvent layout changed");
+static_assert(sizeof(SnapshotRecord) == 12, "SnapshotRecord layout changed");
+static_assert(sizeof(PublishHeader) == 12, "PublishHeader layout changed");
+
+// One ring slot: a record, or the end of a batch of them.
+struct PublishRecord {
+  enum class Kind : uint8_t {
+    kEvent,
+    kEndOfMessage, // events of one consumed payload are complete
+    kSnapshot,
+    kEndOfSnapshot,
+  };
+
+  Kind kind;
+  union {
+    AnalyticsEvent event;
+    SnapshotRecord snapshot;
+  };
+};
+
+using PublishQueue = SpscRing<PublishRecord>;
+
+class Publisher {
+public:
+  // Binds the socket and starts the thread, with `producers` queues of
+  // `[events] publish_queue` records.
+  Publisher(const Config &cfg, size_t producers);
+  ~Publisher();
+
+  Publisher(const Publisher &) = delete;
+  Publisher &operator=(const Publisher &) = delete;
+
+  // Queue of consumer thread `producer`; it must be its only writer.
+  PublishQueue &queue(size_t producer) { return *queues_[producer]; }
+
+  // Drains every queue, sends what is pending and joins the thread. Call
+  // once the consumers have stopped.
+  void stop();
+
+  // Messages sent; call after `stop`.
+  uint64_t messages() const { return messages_; }
+
+private:
+  void run();
+  void add(size_t producer, const PublishRecord &record);
+  void flush_events(std::vector<AnalyticsEvent> &events);
+  void flush_snapshot(std::vector<SnapshotRecord> &snapshot);
+  void send(const char *topic);
+
+  void encode(const std::vector<AnalyticsEvent> &events);
+  void encode(const std::vector<SnapshotRecord> &snapshot);
+
+  zmq::context_t ctx_{1};
+  zmq::socket_t socket_;
+  WireFormat format_;
+  std::chrono::milliseconds interval_;
+
+  std::vector<std::unique_ptr<PublishQueue>> queues_;
+  // Per queue; with an interval, every queue's events go to events_[0].
+  std::vector<std::vector<AnalyticsEvent>> events_;
+  std::vector<std::vector<SnapshotRecord>> snapshots_;
+  std::string out_; // payload being encoded
+  uint64_t messages_ = 0;
+
+  std::atomic<bool> stopping_{false};
+  std::thread thread_;
+};
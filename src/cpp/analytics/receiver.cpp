@@ -0,0 +1,49 @@
+#include "analytics/receiver.h"
+
+Receiver::Receiver(zmq::socket_t &socket, const ZmqConfig &cfg)
+    : socket_(socket),
+      payloads_(static_cast<size_t>(cfg.batch_size > 0 ? cfg.batch_size : 1)),
+      max_latency_(cfg.batch_max_latency_us) {}
+
+bool Receiver::recv_one(zmq::recv_flags flags) {
+  if (!socket_.recv(topic_, flags))
+    return false;
+  // Multipart messages arrive atomically: once the topic is here, so is the
+  // payload.
+  if (!socket_.recv(payloads_[count_], zmq::recv_flags::none))
+    return false;
+  if (capture_ != nullptr)
+    capture_->append(topic_, payloads_[count_]);
+  return true;
+}
+
+size_t Receiver::recv_batch() {
+  // I/O blocking recv
+  return fill(zmq::recv_flags::none);
+}
+
+size_t Receiver::poll_batch() { return fill(zmq::recv_flags::dontwait); }
+
+size_t Receiver::fill(zmq::recv_flags first) {
+  count_ = 0;
+
+  if (!recv_one(first))
+    return 0;
+  count_++;
+
+  if (payloads_.size() == 1)
+    return count_;
+
+  auto start = std::chrono::steady_clock::now();
+  while (count_ < payloads_.size()) {
+    if (!recv_one(zmq::recv_flags::dontwait))
+      break;
+    count_++;
+
+    if (count_ % kClockCheckInterval == 0 &&
+        std::chrono::steady_clock::now() - start >= max_latency_) {
+      break;
+    }
+  }
+  return count_;
+}
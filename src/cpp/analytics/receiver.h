@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "analytics/capture.h"
+#include "common/config.h"
+#include <zmq.hpp>
+
+// Batched receive of `(topic, payload)` multipart messages.
+//
+// `recv_batch` blocks for the first message, then drains up to
+// `batch_size - 1` more that are already queued with ZMQ_DONTWAIT, stopping
+// early once `batch_max_latency_us` has passed since the first one arrived.
+// Under bursty load this turns one wake-up per message into one per batch,
+// and decode then walks the batch back to back. `batch_size = 1` is the
+// plain one-message-per-recv loop.
+class Receiver {
+public:
+  Receiver(zmq::socket_t &socket, const ZmqConfig &cfg);
+
+  // Returns the number of payloads received; 0 when the socket is done.
+  size_t recv_batch();
+
+  // Same, but returns 0 instead of blocking when nothing is queued. Used
+  // from an EventLoop readable callback.
+  size_t poll_batch();
+
+  zmq::socket_t &socket() { return socket_; }
+
+  zmq::message_t *begin() { return payloads_.data(); }
+  zmq::message_t *end() { return payloads_.data() + count_; }
+  size_t size() const { return count_; }
+
+  // Records every received message to `capture` (capture.mode = "record").
+  void set_capture(CaptureWriter *capture) { capture_ = capture; }
+
+private:
+  // Reads one multipart message into the next slot.
+  bool recv_one(zmq::recv_flags flags);
+
+  // Receives the first message with `first`, then drains.
+  size_t fill(zmq::recv_flags first);
+
+  // Reading the clock is cheap but not free; only check the latency bound
+  // every few drained messages.
+  static constexpr size_t kClockCheckInterval = 8;
+
+  zmq::socket_t &socket_;
+  zmq::message_t topic_;
+  std::vector<zmq::message_t> payloads_;
+  size_t count_ = 0;
+  std::chrono::microseconds max_latency_;
+  CaptureWriter *capture_ = nullptr;
+};
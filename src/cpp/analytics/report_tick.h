@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Cold-path report requests. The event loop's report timer calls
+// `request_report` (any thread); each consumer thread holds a `ReportTick`
+// and checks `due()` after a message — one relaxed load, no clock read.
+//
+// The sliding-window bucket timer works the same way (`close_window_bucket`
+// / `WindowTick`), except consumers need to know how many ticks they missed.
+
+inline std::atomic<uint32_t> g_report_tick{0};
+
+inline void request_report() {
+  g_report_tick.fetch_add(1, std::memory_order_relaxed);
+}
+
+struct ReportTick {
+  uint32_t seen = 0;
+
+  bool due() {
+    uint32_t tick = g_report_tick.load(std::memory_order_relaxed);
+    if (tick == seen)
+      return false;
+    seen = tick;
+    return true;
+  }
+};
+
+inline std::atomic<uint32_t> g_window_tick{0};
+
+inline void close_window_bucket() {
+  g_window_tick.fetch_add(1, std::memory_order_relaxed);
+}
+
+struct WindowTick {
+  uint32_t seen = 0;
+
+  // Buckets closed since the last call.
+  uint32_t elapsed() {
+    uint32_t tick = g_window_tick.load(std::memory_order_relaxed);
+    uint32_t n = tick - seen;
+    seen = tick;
+    return n;
+  }
+};
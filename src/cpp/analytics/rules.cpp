@@ -0,0 +1,573 @@
+#include "analytics/rules.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+// Deepest mask stack a program may need (nesting of and / or / not).
+constexpr size_t kMaxDepth = 16;
+
+// One mask byte per detection: 1 where `test(column[i])` holds.
+template <typename T, typename Test>
+void fill_mask(const T *__restrict column, uint8_t *__restrict out, size_t n,
+               Test test) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = test(static_cast<float>(column[i]));
+  }
+}
+
+void and_masks(uint8_t *__restrict a, const uint8_t *__restrict b, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    a[i] &= b[i];
+  }
+}
+
+void or_masks(uint8_t *__restrict a, const uint8_t *__restrict b, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    a[i] |= b[i];
+  }
+}
+
+uint32_t count_mask(const uint8_t *__restrict mask, size_t n) {
+  uint32_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += mask[i];
+  }
+  return count;
+}
+
+// Sets (rule 0: assigns) bit `r` of every detection's rule bits.
+void add_rule_bits(uint64_t *__restrict bits, const uint8_t *__restrict mask,
+                   size_t r, size_t n) {
+  if (r == 0) {
+    for (size_t i = 0; i < n; i++) {
+      bits[i] = mask[i];
+    }
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    bits[i] |= uint64_t{mask[i]} << r;
+  }
+}
+
+// One mask byte per bit of `bits`.
+void expand_bits(const uint64_t *__restrict bits, uint8_t *__restrict out,
+                 size_t n) {
+  for (size_t w = 0; w * 64 < n; w++) {
+    uint64_t word = bits[w];
+    size_t end = std::min<size_t>(64, n - w * 64);
+    for (size_t b = 0; b < end; b++) {
+      out[w * 64 + b] = static_cast<uint8_t>((word >> b) & 1);
+    }
+  }
+}
+
+// Squared speeds: no sqrt (which keeps errno and the loop scalar); the
+// compiler squares the constant instead.
+void squared_speeds(const float *__restrict vx, const float *__restrict vy,
+                    float *__restrict out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = vx[i] * vx[i] + vy[i] * vy[i];
+  }
+}
+
+void tag(int worker) {
+  std::cerr << "[RULE]";
+  if (worker >= 0)
+    std::cerr << " w" << worker;
+}
+
+} // namespace
+
+// ================= Compiler =================
+//
+// Recursive descent over `when`, emitting postfix code as it goes:
+//
+//   or      := and ("or" and)*
+//   and     := not ("and" not)*
+//   not     := "not" not | primary
+//   primary := "(" or ")" | "inside" "(" zone ")"
+//            | "class" "in" "[" int ("," int)* "]"
+//            | operand cmp number [unit]
+//   operand := field | "dwell" "(" zone ")"
+
+class RuleSet::Compiler {
+public:
+  Compiler(RuleSet &set, const RuleConfig &rule, const ZoneSet &zones,
+           int fps, bool motion)
+      : set_(set), rule_(rule), text_(rule.when), zones_(zones), fps_(fps),
+        motion_(motion) {}
+
+  // Appends the rule's program to `set_.code_`; exits if it is invalid.
+  void compile() {
+    parse_or();
+    skip_space();
+    if (pos_ < text_.size())
+      fail("unexpected '" + text_.substr(pos_) + "'");
+  }
+
+  size_t max_depth() const { return max_depth_; }
+
+private:
+  void parse_or() {
+    parse_and();
+    while (accept_word("or")) {
+      parse_and();
+      emit(Op::kOr, -1);
+    }
+  }
+
+  void parse_and() {
+    parse_not();
+    while (accept_word("and")) {
+      parse_not();
+      emit(Op::kAnd, -1);
+    }
+  }
+
+  void parse_not() {
+    if (accept_word("not")) {
+      parse_not();
+      emit(Op::kNot, 0);
+      return;
+    }
+    parse_primary();
+  }
+
+  void parse_primary() {
+    if (accept("(")) {
+      parse_or();
+      expect(")");
+      return;
+    }
+    std::string word = read_word();
+    if (word.empty())
+      fail("expected a condition");
+    if (word == "inside") {
+      emit(Op::kInside, 1, Cmp::kEq, zone_arg());
+      return;
+    }
+    if ((word == "class" || word == "class_id") && accept_word("in")) {
+      class_set();
+      return;
+    }
+    if (word == "dwell") {
+      size_t zone = zone_arg();
+      auto &dwell = set_.dwell_zones_;
+      auto it = std::find(dwell.begin(), dwell.end(), zone);
+      if (it == dwell.end())
+        it = dwell.insert(dwell.end(), zone);
+      set_.needs_track_ = true;
+      compare(Op::kCompareInt,
+              kDwell + static_cast<size_t>(it - dwell.begin()), kFrames);
+      return;
+    }
+    field(word);
+  }
+
+  // Units a comparison's constant may carry.
+  enum Unit { kPlain, kFrames, kPixelsPerSecond };
+
+  void field(const std::string &word) {
+    if (word == "class" || word == "class_id") {
+      compare(Op::kCompareInt, kClass, kPlain);
+    } else if (word == "age") {
+      set_.needs_track_ = true;
+      compare(Op::kCompareInt, kAge, kFrames);
+    } else if (word == "hits") {
+      set_.needs_track_ = true;
+      compare(Op::kCompareInt, kHits, kPlain);
+    } else if (word == "confidence") {
+      compare(Op::kCompareFloat, kConfidence, kPlain);
+    } else if (word == "left") {
+      compare(Op::kCompareFloat, kLeft, kPlain);
+    } else if (word == "top") {
+      compare(Op::kCompareFloat, kTop, kPlain);
+    } else if (word == "width") {
+      compare(Op::kCompareFloat, kWidth, kPlain);
+    } else if (word == "height") {
+      compare(Op::kCompareFloat, kHeight, kPlain);
+    } else if (word == "x") {
+      compare(Op::kCompareFloat, kAnchorX, kPlain);
+    } else if (word == "y") {
+      compare(Op::kCompareFloat, kAnchorY, kPlain);
+    } else if (word == "vx" || word == "vy" || word == "speed") {
+      if (!motion_)
+        fail(word + " needs [motion] enabled");
+      if (word == "speed")
+        set_.needs_speed_ = true;
+      size_t column = word == "vx" ? kVelocityX
+                      : word == "vy" ? kVelocityY
+                                     : kSpeed;
+      compare(Op::kCompareFloat, column, kPixelsPerSecond);
+    } else {
+      fail("unknown field '" + word + "'");
+    }
+  }
+
+  // `cmp number [unit]` after an operand.
+  void compare(Op op, size_t column, Unit unit) {
+    Cmp cmp = comparison();
+    skip_space();
+    const char *begin = text_.c_str() + pos_;
+    char *end = nullptr;
+    float value = std::strtof(begin, &end);
+    if (end == begin)
+      fail("expected a number");
+    pos_ += static_cast<size_t>(end - begin);
+
+    std::string suffix;
+    while (pos_ < text_.size() &&
+           std::isalpha(static_cast<unsigned char>(text_[pos_]))) {
+      suffix += text_[pos_++];
+    }
+    if (unit == kFrames && suffix == "s") {
+      value *= static_cast<float>(fps_);
+    } else if (unit == kFrames && suffix == "ms") {
+      value *= static_cast<float>(fps_) / 1000.0f;
+    } else if (unit == kPixelsPerSecond) {
+      if (!suffix.empty())
+        fail("speeds are in px/s, without a unit");
+      value /= static_cast<float>(fps_); // px/s -> px/frame
+      // Against speed squared; keeping the sign keeps every comparison
+      // right for negative constants too.
+      if (column == kSpeed)
+        value *= std::fabs(value);
+    } else if (!suffix.empty()) {
+      fail("unexpected unit '" + suffix + "'");
+    }
+    emit(op, 1, cmp, column, value);
+  }
+
+  Cmp comparison() {
+    skip_space();
+    static const struct {
+      const char *text;
+      Cmp cmp;
+    } kCmps[] = {{"==", Cmp::kEq}, {"!=", Cmp::kNe}, {"<=", Cmp::kLe},
+                 {">=", Cmp::kGe}, {"<", Cmp::kLt},  {">", Cmp::kGt}};
+    for (const auto &c : kCmps) {
+      if (accept(c.text))
+        return c.cmp;
+    }
+    fail("expected == != < <= > or >=");
+  }
+
+  // "[" int ("," int)* "]" after `class in`.
+  void class_set() {
+    expect("[");
+    // Ids 0..255, then one entry for every other id.
+    std::vector<uint8_t> member(257, 0);
+    do {
+      skip_space();
+      const char *begin = text_.c_str() + pos_;
+      char *end = nullptr;
+      long id = std::strtol(begin, &end, 10);
+      if (end == begin || id < 0 || id > 255)
+        fail("class ids must be 0..255");
+      pos_ += static_cast<size_t>(end - begin);
+      member[static_cast<size_t>(id)] = 1;
+    } while (accept(","));
+    expect("]");
+    set_.classes_.push_back(std::move(member));
+    emit(Op::kClassIn, 1, Cmp::kEq, set_.classes_.size() - 1);
+  }
+
+  // "(" zone ")": a zone name of the rule's source.
+  size_t zone_arg() {
+    expect("(");
+    size_t close = text_.find(')', pos_);
+    if (close == std::string::npos)
+      fail("expected ')'");
+    std::string name = text_.substr(pos_, close - pos_);
+    name.erase(0, name.find_first_not_of(' '));
+    name.erase(name.find_last_not_of(' ') + 1);
+    pos_ = close + 1;
+    if (rule_.all_sources)
+      fail("zones need the rule's source_id");
+    for (size_t z = 0; z < zones_.size(); z++) {
+      if (zones_.name(z) == name)
+        return z;
+    }
+    fail("no zone '" + name + "' on source " +
+         std::to_string(rule_.source_id));
+  }
+
+  // Appends an instruction that changes the stack depth by `push`.
+  void emit(Op op, int push, Cmp cmp = Cmp::kEq, size_t arg = 0,
+            float value = 0.0f) {
+    set_.code_.push_back(Instr{op, cmp, static_cast<uint16_t>(arg), value});
+    depth_ = static_cast<size_t>(static_cast<int>(depth_) + push);
+    max_depth_ = std::max(max_depth_, depth_);
+    if (max_depth_ > kMaxDepth)
+      fail("nested too deeply");
+  }
+
+  void skip_space() {
+    while (pos_ < text_.size() &&
+           std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+      pos_++;
+    }
+  }
+
+  bool accept(const char *token) {
+    skip_space();
+    size_t len = std::char_traits<char>::length(token);
+    if (text_.compare(pos_, len, token) != 0)
+      return false;
+    pos_ += len;
+    return true;
+  }
+
+  void expect(const char *token) {
+    if (!accept(token))
+      fail(std::string("expected '") + token + "'");
+  }
+
+  // Identifier at the cursor, consumed; empty if there is none.
+  std::string read_word() {
+    skip_space();
+    size_t begin = pos_;
+    while (pos_ < text_.size() &&
+           (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+            text_[pos_] == '_')) {
+      pos_++;
+    }
+    return text_.substr(begin, pos_ - begin);
+  }
+
+  // Consumes `word` if it is the next identifier.
+  bool accept_word(const char *word) {
+    size_t saved = pos_;
+    if (read_word() == word)
+      return true;
+    pos_ = saved;
+    return false;
+  }
+
+  [[noreturn]] void fail(const std::string &what) const {
+    std::cerr << "[RULE] " << rule_.name << ": " << what << " at column "
+              << pos_ + 1 << " of \"" << text_ << "\"\n";
+    std::exit(1);
+  }
+
+  RuleSet &set_;
+  const RuleConfig &rule_;
+  const std::string &text_;
+  const ZoneSet &zones_;
+  int fps_;
+  bool motion_;
+  size_t pos_ = 0;
+  size_t depth_ = 0;
+  size_t max_depth_ = 0;
+};
+
+// ================= RuleSet =================
+
+RuleSet::RuleSet(const Config &cfg, int32_t source_id, const ZoneSet &zones) {
+  add_rules(cfg, false, source_id, zones);
+}
+
+RuleSet::RuleSet(const Config &cfg) { add_rules(cfg, true, 0, ZoneSet()); }
+
+void RuleSet::add_rules(const Config &cfg, bool all_only, int32_t source_id,
+                        const ZoneSet &zones) {
+  for (const auto &rule : cfg.rules) {
+    if (!rule.all_sources && (all_only || rule.source_id != source_id))
+      continue;
+    if (rules_.size() == kMaxRules) {
+      std::cerr << "[RULE] " << rule.name << ": more than " << kMaxRules
+                << " rules on one source\n";
+      std::exit(1);
+    }
+    Compiler compiler(*this, rule, zones, cfg.analytics.fps,
+                      cfg.motion.enabled);
+    auto first = static_cast<uint32_t>(code_.size());
+    compiler.compile();
+    rules_.push_back(Rule{rule.name, first,
+                          static_cast<uint32_t>(code_.size()) - first});
+    depth_ = std::max(depth_, compiler.max_depth());
+  }
+  if (rules_.empty())
+    return;
+
+  auto n = static_cast<size_t>(std::max(1, cfg.analytics.max_detections));
+  stride_ = round_up_to_line<float>(n);
+  stack_ = make_aligned_array<uint8_t>(depth_ * stride_);
+  bits_ = make_aligned_array<uint64_t>(stride_);
+  if (needs_speed_) {
+    speed_ = make_aligned_array<float>(stride_);
+    floats_[kSpeed] = speed_.get();
+  }
+  if (needs_track_) {
+    std::fill_n(dwell_column_, ZoneSet::kMaxZones, kNoColumn);
+    for (size_t k = 0; k < dwell_zones_.size(); k++) {
+      dwell_column_[dwell_zones_[k]] = static_cast<uint8_t>(k);
+    }
+    track_cols_ = make_aligned_array<int32_t>(
+        (kDwell - kAge + dwell_zones_.size()) * stride_);
+    for (size_t c = kAge; c < kDwell + dwell_zones_.size(); c++) {
+      ints_[c] = track_cols_.get() + (c - kAge) * stride_;
+    }
+  }
+}
+
+void RuleSet::evaluate(const FrameColumns &frame, const ZoneSet &zones,
+                       TrackState *const *states, EventBuffer &events) {
+  size_t n = frame.size();
+  floats_[kConfidence] = frame.confidence();
+  floats_[kLeft] = frame.left();
+  floats_[kTop] = frame.top();
+  floats_[kWidth] = frame.width();
+  floats_[kHeight] = frame.height();
+  floats_[kAnchorX] = frame.anchor_x();
+  floats_[kAnchorY] = frame.anchor_y();
+  floats_[kVelocityX] = frame.velocity_x();
+  floats_[kVelocityY] = frame.velocity_y();
+  ints_[kClass] = frame.class_id();
+  if (needs_speed_)
+    squared_speeds(frame.velocity_x(), frame.velocity_y(), speed_.get(), n);
+
+  // Track columns: one gather per detection, shared by every rule.
+  int32_t now = frame.frame_num();
+  if (needs_track_) {
+    int32_t *age = track_cols_.get();
+    int32_t *hits = age + stride_;
+    int32_t *dwells = hits + stride_;
+    for (size_t k = 0; k < dwell_zones_.size(); k++) {
+      std::fill_n(dwells + k * stride_, n, 0);
+    }
+    for (size_t i = 0; i < n; i++) {
+      const TrackState *state = states[i];
+      if (state == nullptr) {
+        age[i] = 0;
+        hits[i] = 0;
+        continue;
+      }
+      age[i] = now - state->first_frame;
+      hits[i] = static_cast<int32_t>(state->hits);
+      for (size_t s = 0; s < ZoneDwell::kSlots; s++) {
+        uint8_t zone = state->dwell.zone[s];
+        if (zone != ZoneDwell::kFree && dwell_column_[zone] != kNoColumn) {
+          dwells[dwell_column_[zone] * stride_ + i] =
+              now - state->dwell.since[s];
+        }
+      }
+    }
+  }
+
+  uint64_t *bits = bits_.get();
+  for (size_t r = 0; r < rules_.size(); r++) {
+    const uint8_t *match = run(rules_[r], zones, n);
+    rules_[r].matched += count_mask(match, n);
+    add_rule_bits(bits, match, r, n);
+  }
+
+  // One pass over the tracks for every rule: rising edges fire, falling
+  // edges re-arm.
+  const int32_t *track = frame.track_id();
+  const int32_t *cls = frame.class_id();
+  for (size_t i = 0; i < n; i++) {
+    TrackState *state = states[i];
+    if (state == nullptr)
+      continue;
+    uint64_t rising = bits[i] & ~state->rules;
+    state->rules = bits[i];
+    for (; rising != 0; rising &= rising - 1) {
+      auto r = static_cast<size_t>(__builtin_ctzll(rising));
+      rules_[r].fired++;
+      events.push(AnalyticsEvent{EventType::kRule, 0, static_cast<uint16_t>(r),
+                                 frame.source_id(), now, track[i], cls[i],
+                                 -1});
+    }
+  }
+}
+
+const uint8_t *RuleSet::run(const Rule &r, const ZoneSet &zones, size_t n) {
+  size_t sp = 0;
+  for (uint32_t pc = r.first; pc < r.first + r.count; pc++) {
+    const Instr &in = code_[pc];
+    switch (in.op) {
+    case Op::kCompareFloat:
+    case Op::kCompareInt: {
+      uint8_t *out = mask(sp++);
+      float v = in.value;
+      // Same loops for both column types; ints compare as floats.
+      auto run_cmp = [&](const auto *col) {
+        switch (in.cmp) {
+        case Cmp::kEq:
+          fill_mask(col, out, n, [v](float x) { return x == v; });
+          break;
+        case Cmp::kNe:
+          fill_mask(col, out, n, [v](float x) { return x != v; });
+          break;
+        case Cmp::kLt:
+          fill_mask(col, out, n, [v](float x) { return x < v; });
+          break;
+        case Cmp::kLe:
+          fill_mask(col, out, n, [v](float x) { return x <= v; });
+          break;
+        case Cmp::kGt:
+          fill_mask(col, out, n, [v](float x) { return x > v; });
+          break;
+        case Cmp::kGe:
+          fill_mask(col, out, n, [v](float x) { return x >= v; });
+          break;
+        }
+      };
+      if (in.op == Op::kCompareFloat) {
+        run_cmp(floats_[in.arg]);
+      } else {
+        run_cmp(ints_[in.arg]);
+      }
+      break;
+    }
+    case Op::kInside: {
+      uint8_t *out = mask(sp++);
+      expand_bits(zones.inside_bits(in.arg), out, n);
+      break;
+    }
+    case Op::kClassIn: {
+      uint8_t *out = mask(sp++);
+      const uint8_t *member = classes_[in.arg].data();
+      const int32_t *cls = ints_[kClass];
+      for (size_t i = 0; i < n; i++) {
+        out[i] = member[std::min(static_cast<uint32_t>(cls[i]), 256u)];
+      }
+      break;
+    }
+    case Op::kAnd:
+      sp--;
+      and_masks(mask(sp - 1), mask(sp), n);
+      break;
+    case Op::kOr:
+      sp--;
+      or_masks(mask(sp - 1), mask(sp), n);
+      break;
+    case Op::kNot: {
+      uint8_t *m = mask(sp - 1);
+      for (size_t i = 0; i < n; i++) {
+        m[i] ^= 1;
+      }
+      break;
+    }
+    }
+  }
+  return mask(0);
+}
+
+void RuleSet::print_interval(int worker, int32_t source_id) {
+  for (auto &rule : rules_) {
+    tag(worker);
+    std::cerr << " source " << source_id << " " << rule.name << ": "
+              << rule.matched << " detections matched, " << rule.fired
+              << " fired (total " << rule.fired_total + rule.fired << ")\n";
+    rule.fired_total += rule.fired;
+    rule.matched = 0;
+    rule.fired = 0;
+  }
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "analytics/aligned.h"
+#include "analytics/events.h"
+#include "analytics/frame_columns.h"
+#include "analytics/track_table.h"
+#include "analytics/zones.h"
+#include "common/config.h"
+
+// ================= Rules =================
+//
+// User conditions from `[[rules]]` in config.toml, e.g.
+//
+//   when = "class == 0 and confidence > 0.9 and dwell(entrance) > 5s"
+//
+// Operands: class (or class_id), confidence, left, top, width, height,
+// x / y (bbox bottom-centre), vx / vy / speed (px/s, needs [motion]), the
+// track's age and hits, dwell(zone) (time in the zone, as tracked for zone
+// events); inside(zone) and `class in [0, 2]` are tests of their own.
+// Comparisons are == != < <= > >=, combined with and, or, not and
+// parentheses. Times take s or ms; plain numbers are frames.
+//
+// Each rule is compiled at startup, per source, into a flat postfix
+// program: zone names become indices, units become frames or px/frame. A
+// frame is evaluated column-at-a-time: every instruction is one tight loop
+// over the whole batch (an SoA column against a constant, or an and / or /
+// not of two masks), leaving a byte mask per detection on a small stack.
+// Dispatch is one switch per instruction and frame, not per detection, and
+// the loops vectorize, so a rule costs about what the same test written by
+// hand would; no virtual calls, strings or allocation at run time.
+//
+// A rule fires (an event) when it becomes true for a track, and re-arms
+// once it is false again; each detection's results for all rules are
+// gathered into one uint64_t, so firing takes a single pass over the
+// frame's tracks. Matching detections, tracked or not, are counted per
+// interval.
+
+class RuleSet {
+public:
+  // Most rules one source may have; a track's rule state is a uint64_t.
+  static constexpr size_t kMaxRules = 64;
+
+  // Rules of `source_id` and the all-source ones from `cfg.rules`, zone
+  // names looked up in `zones`. Exits on a rule that does not compile.
+  RuleSet(const Config &cfg, int32_t source_id, const ZoneSet &zones);
+
+  // Only the all-source rules (a source seen after startup).
+  explicit RuleSet(const Config &cfg);
+
+  size_t size() const { return rules_.size(); }
+  const std::string &name(size_t rule) const { return rules_[rule].name; }
+
+  // ---------- hot path ----------
+
+  // Evaluates every rule over `frame`. `states[i]` is detection i's track
+  // (null if untracked); `zones` must have evaluated this frame.
+  void evaluate(const FrameColumns &frame, const ZoneSet &zones,
+                TrackState *const *states, EventBuffer &events);
+
+  // ---------- cold path ----------
+
+  // Prints matches and firings since the last call.
+  void print_interval(int worker, int32_t source_id);
+
+private:
+  enum class Op : uint8_t {
+    kCompareFloat, // arg = FloatColumn
+    kCompareInt,   // arg = IntColumn
+    kInside,       // arg = zone
+    kClassIn,      // arg = class set
+    kAnd,
+    kOr,
+    kNot,
+  };
+  enum class Cmp : uint8_t { kEq, kNe, kLt, kLe, kGt, kGe };
+
+  struct Instr {
+    Op op;
+    Cmp cmp;
+    uint16_t arg;
+    float value;
+  };
+
+  // Float operands are FrameColumns columns, or derived from them; int
+  // operands are the class column and values of the detection's track.
+  enum FloatColumn {
+    kConfidence,
+    kLeft,
+    kTop,
+    kWidth,
+    kHeight,
+    kAnchorX,
+    kAnchorY,
+    kVelocityX,
+    kVelocityY,
+    kSpeed, // derived: vx^2 + vy^2
+    kFloatColumns
+  };
+  enum IntColumn {
+    kClass,
+    kAge,
+    kHits,
+    kDwell, // kDwell + k: k-th zone of dwell_zones_
+    kIntColumns = kDwell + ZoneSet::kMaxZones
+  };
+
+  struct Rule {
+    std::string name;
+    uint32_t first; // code_[first, first + count)
+    uint32_t count;
+    uint64_t matched = 0; // detections since the last print
+    uint64_t fired = 0;   // since the last print
+    uint64_t fired_total = 0;
+  };
+
+  static constexpr uint8_t kNoColumn = 0xff;
+
+  class Compiler;
+
+  void add_rules(const Config &cfg, bool all_only, int32_t source_id,
+                 const ZoneSet &zones);
+  // Runs rule `r`'s program over n detections; returns its result mask.
+  const uint8_t *run(const Rule &r, const ZoneSet &zones, size_t n);
+  uint8_t *mask(size_t depth) { return stack_.get() + depth * stride_; }
+
+  std::vector<Rule> rules_;
+  std::vector<Instr> code_;                   // every rule's program
+  std::vector<std::vector<uint8_t>> classes_; // class sets, byte per id
+  std::vector<size_t> dwell_zones_;           // zone of each dwell column
+  uint8_t dwell_column_[ZoneSet::kMaxZones];  // zone -> dwell column
+  bool needs_speed_ = false;
+  bool needs_track_ = false;
+
+  size_t stride_ = 0;                // per-detection column length
+  size_t depth_ = 0;                 // deepest stack any program needs
+  AlignedArray<uint8_t> stack_;      // depth_ x stride_ masks
+  AlignedArray<uint64_t> bits_;      // per detection, bit per rule now true
+  AlignedArray<float> speed_;        // squared, (px/frame)^2
+  AlignedArray<int32_t> track_cols_; // (kDwell + dwell zones) x stride_
+  const float *floats_[kFloatColumns] = {};
+  const int32_t *ints_[kIntColumns] = {};
+};
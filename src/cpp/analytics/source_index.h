@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Maps arbitrary source ids to dense slots [0, max_sources) in order of first
+// appearance, so per-source state can live in flat arrays. Sources are few
+// (max_sources), so lookup is a linear scan with the last hit cached — a
+// message's frames usually come from one source.
+class SourceIndex {
+public:
+  explicit SourceIndex(int max_sources)
+      : capacity_(static_cast<size_t>(max_sources > 0 ? max_sources : 1)) {
+    ids_.reserve(capacity_);
+  }
+
+  // Slot of `source_id`, assigning the next free one on first sight; -1 once
+  // every slot is taken by other sources.
+  int slot(int32_t source_id) {
+    if (last_ >= 0 && ids_[static_cast<size_t>(last_)] == source_id)
+      return last_;
+    for (size_t i = 0; i < ids_.size(); i++) {
+      if (ids_[i] == source_id)
+        return last_ = static_cast<int>(i);
+    }
+    if (ids_.size() == capacity_)
+      return -1;
+    ids_.push_back(source_id);
+    return last_ = static_cast<int>(ids_.size() - 1);
+  }
+
+  // Slot of a source already seen; -1 otherwise.
+  int find(int32_t source_id) const {
+    for (size_t i = 0; i < ids_.size(); i++) {
+      if (ids_[i] == source_id)
+        return static_cast<int>(i);
+    }
+    return -1;
+  }
+
+  size_t size() const { return ids_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  // Source id held by `slot`.
+  int32_t id(size_t slot) const { return ids_[slot]; }
+
+private:
+  size_t capacity_;
+  std::vector<int32_t> ids_;
+  int last_ = -1;
+};
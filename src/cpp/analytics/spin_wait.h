@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Hint to the core that we are in a spin loop (lets the sibling hyperthread
+// run, saves power). Falls back to a compiler barrier elsewhere.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#else
+  asm volatile("" ::: "memory");
+#endif
+}
+
+// Spin for `limit` iterations, then back off: with `busy`, yield the time
+// slice and keep the core; otherwise sleep, doubling from kMinSleep up to
+// kMaxSleep, so an idle thread costs no CPU.
+struct SpinWait {
+  static constexpr std::chrono::microseconds kMinSleep{50};
+  static constexpr std::chrono::microseconds kMaxSleep{1000};
+
+  int limit;
+  bool busy;
+  int spins = 0;
+  std::chrono::microseconds sleep{0};
+
+  explicit SpinWait(int spin_limit, bool busy_poll = false)
+      : limit(spin_limit), busy(busy_poll) {}
+
+  inline void wait() {
+    if (spins < limit) {
+      spins++;
+      cpu_relax();
+    } else if (busy) {
+      std::this_thread::yield();
+    } else {
+      sleep = sleep.count() == 0 ? kMinSleep : std::min(2 * sleep, kMaxSleep);
+      std::this_thread::sleep_for(sleep);
+    }
+  }
+
+  inline void reset() {
+    spins = 0;
+    sleep = std::chrono::microseconds{0};
+  }
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free single-producer / single-consumer ring.
+//
+// Slots are allocated once; push/pop move-assign into and out of them, so
+// with types like zmq::message_t (whose move-assign swaps) buffers are
+// recycled instead of freed. Head and tail live on separate cache lines, and
+// each side caches the other's index to avoid pulling the remote line on
+// every operation.
+template <typename T> class SpscRing {
+public:
+  // `capacity` is rounded up to a power of two.
+  explicit SpscRing(size_t capacity)
+      : capacity_(round_up_pow2(capacity < 2 ? 2 : capacity)),
+        mask_(capacity_ - 1), slots_(new T[capacity_]) {}
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  // Producer only. Moves from `item` only on success.
+  bool try_push(T &item) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == capacity_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == capacity_)
+        return false;
+    }
+    slots_[tail & mask_] = std::move(item);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only.
+  bool try_pop(T &out) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_)
+        return false;
+    }
+    out = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called concurrently; exact from either side's view of
+  // its own index.
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const { return capacity_; }
+
+private:
+  static constexpr size_t kCacheLine = 64;
+
+  static size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n)
+      p <<= 1;
+    return p;
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<T[]> slots_;
+
+  alignas(kCacheLine) std::atomic<size_t> head_{0}; // written by consumer
+  size_t cached_tail_ = 0;                          // consumer-local
+
+  alignas(kCacheLine) std::atomic<size_t> tail_{0}; // written by producer
+  size_t cached_head_ = 0;                          // producer-local
+};
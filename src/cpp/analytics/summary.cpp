@@ -0,0 +1,65 @@
+#include "analytics/summary.h"
+
+#include <iostream>
+
+#include "analytics/unique_tracks.h"
+
+namespace {
+
+void tag(int worker) {
+  std::cerr << "[SUMMARY]";
+  if (worker >= 0)
+    std::cerr << " w" << worker;
+}
+
+void print_uniques(const char *label, const UniqueTracks *uniques) {
+  if (uniques != nullptr)
+    std::cerr << ", " << label << " ~" << uniques->estimate();
+}
+
+} // namespace
+
+Summary::Summary(size_t max_detections)
+    : buckets_(make_aligned_array<uint32_t>(
+          round_up_to_line<uint32_t>(max_detections > 0 ? max_detections : 1))),
+      counts_(make_aligned_array<uint64_t>(2 * kBuckets)) {}
+
+void Summary::print_interval(int worker, const UniqueTracks *uniques) {
+  auto now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - interval_start_).count();
+  double avg_objects =
+      frames_ > 0 ? static_cast<double>(objects_) / frames_ : 0.0;
+
+  tag(worker);
+  std::cerr << " over " << elapsed << " s: frames " << interval_frames_
+            << ", processing rate "
+            << (elapsed > 0.0 ? interval_frames_ / elapsed : 0.0)
+            << " FPS";
+  print_uniques("tracks", uniques);
+  std::cerr << ", avg objects/frame " << avg_objects << "\n";
+  for (size_t c = 0; c < kBuckets; c++) {
+    uint64_t count = class_count(c);
+    if (count == 0)
+      continue;
+    tag(worker);
+    if (c == kMaxClasses) {
+      std::cerr << "   class other: ";
+    } else {
+      std::cerr << "   class " << c << ": ";
+    }
+    std::cerr << count << " detections\n";
+  }
+
+  interval_start_ = now;
+  interval_frames_ = 0;
+}
+
+void Summary::print_final(int worker, const UniqueTracks *uniques) const {
+  if (frames_ == 0)
+    return;
+  tag(worker);
+  std::cerr << " final: frames " << frames_ << ", objects " << objects_;
+  print_uniques("unique tracks", uniques);
+  std::cerr << ", avg objects/frame " << static_cast<double>(objects_) / frames_
+            << "\n";
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "analytics/aligned.h"
+#include "analytics/frame_columns.h"
+
+class UniqueTracks;
+
+// The analytics `analyze.py` logs, kept natively: frames processed, average
+// objects per frame, unique tracks and the per-class detection distribution.
+// One instance per consumer thread; `add_frame` is the per-frame hot path,
+// the `print_*` calls are cold.
+//
+// Unique tracks are UniqueTracks' HyperLogLog estimate, the one [UNIQUE]
+// prints, so a track re-seen after eviction is not counted again.
+class Summary {
+public:
+  // class_ids outside [0, kMaxClasses) are counted under "other".
+  static constexpr size_t kMaxClasses = 256;
+
+  explicit Summary(size_t max_detections);
+
+  // ---------- hot path ----------
+
+  void add_frame(const FrameColumns &frame) {
+    size_t n = frame.size();
+    frames_++;
+    interval_frames_++;
+    objects_ += n;
+
+    // Clamp class ids to histogram buckets: branch-free, vectorizes.
+    const int32_t *cls = frame.class_id();
+    uint32_t *bucket = buckets_.get();
+    for (size_t i = 0; i < n; i++) {
+      auto c = static_cast<uint32_t>(cls[i]);
+      bucket[i] = c < kMaxClasses ? c : static_cast<uint32_t>(kMaxClasses);
+    }
+
+    // Two interleaved histograms, so runs of one class do not serialize on
+    // a single counter's store-to-load dependency.
+    uint64_t *even = counts_.get();
+    uint64_t *odd = counts_.get() + kBuckets;
+    size_t i = 0;
+    for (; i + 1 < n; i += 2) {
+      even[bucket[i]]++;
+      odd[bucket[i + 1]]++;
+    }
+    if (i < n)
+      even[bucket[i]]++;
+  }
+
+  // ---------- cold path ----------
+
+  // analyze.py's periodic summary; starts a new interval. `worker` < 0
+  // leaves the lines untagged; a null `uniques` leaves out unique tracks.
+  void print_interval(int worker, const UniqueTracks *uniques);
+
+  // analyze.py's final summary.
+  void print_final(int worker, const UniqueTracks *uniques) const;
+
+  uint64_t frames() const { return frames_; }
+  uint64_t objects() const { return objects_; }
+  uint64_t class_count(size_t bucket) const {
+    return counts_[bucket] + counts_[kBuckets + bucket];
+  }
+
+private:
+  static constexpr size_t kBuckets = kMaxClasses + 1; // + "other"
+
+  uint64_t frames_ = 0;
+  uint64_t interval_frames_ = 0;
+  uint64_t objects_ = 0;
+  std::chrono::steady_clock::time_point interval_start_ =
+      std::chrono::steady_clock::now();
+
+  AlignedArray<uint32_t> buckets_; // per-detection scratch
+  AlignedArray<uint64_t> counts_;  // 2 x kBuckets
+};
@@ -0,0 +1,183 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One pending timeout. `track_id` / `zone` / `tag` are the owner's to
+// interpret (see track_lifecycle.h); the wheel only looks at `deadline`.
+struct Timer {
+  int64_t deadline; // tick at which the timer is due
+  int32_t track_id;
+  int32_t tag;  // owner's generation check (e.g. frame the track started)
+  uint16_t zone;
+  uint8_t kind;
+};
+
+// Hierarchical timing wheel over an integer tick (here: a source's frame
+// number). Four levels of 64 slots cover 2^24 ticks ahead; a timer lives in
+// the lowest level whose slot period still contains its deadline and is
+// moved one level down when that slot comes up ("cascade"). Scheduling and
+// firing are O(1); a timer is touched at most once per level.
+//
+// Timers are nodes in a pool sized at construction and linked through
+// indices, so scheduling never allocates. Per-level occupancy masks let
+// `advance` skip stretches of empty slots after a gap in the tick.
+class TimingWheel {
+public:
+  static constexpr unsigned kSlotBits = 6;
+  static constexpr size_t kSlots = size_t{1} << kSlotBits;
+  static constexpr unsigned kLevels = 4;
+
+  explicit TimingWheel(size_t max_timers) : nodes_(max_timers) { clear(); }
+
+  // Drops every timer.
+  void clear() {
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      nodes_[i].next = i + 1 < nodes_.size() ? static_cast<int32_t>(i + 1)
+                                             : kNone;
+    }
+    free_ = nodes_.empty() ? kNone : 0;
+    for (auto &level : heads_) {
+      for (auto &head : level)
+        head = kNone;
+    }
+    for (auto &mask : occupied_)
+      mask = 0;
+    size_ = 0;
+  }
+
+  // Returns false (and counts the timer as dropped) when the pool is
+  // exhausted. A deadline at or before the current tick fires on the next.
+  bool schedule(const Timer &timer) {
+    if (free_ == kNone) {
+      dropped_++;
+      return false;
+    }
+    int32_t n = free_;
+    free_ = nodes_[static_cast<size_t>(n)].next;
+    nodes_[static_cast<size_t>(n)].timer = timer;
+    insert(n, std::max(timer.deadline, now_ + 1));
+    size_++;
+    return true;
+  }
+
+  // Moves the current tick to `now`, calling `fire(const Timer &)` for every
+  // timer due by then. `fire` may schedule new timers. An empty wheel jumps
+  // straight to `now`; otherwise an earlier `now` is ignored.
+  template <typename F> void advance(int64_t now, F &&fire) {
+    while (now_ < now || size_ == 0) {
+      if (size_ == 0) {
+        now_ = now;
+        break;
+      }
+      if (occupied_[0] == 0) {
+        // Nothing happens before the next cascade of the lowest occupied
+        // level; skip to just before it.
+        unsigned level = 1;
+        while (occupied_[level] == 0)
+          level++;
+        int64_t last = now_ | ((int64_t{1} << (kSlotBits * level)) - 1);
+        if (last >= now) {
+          now_ = now;
+          break;
+        }
+        now_ = last;
+      }
+      now_++;
+      if ((now_ & static_cast<int64_t>(kSlots - 1)) == 0) {
+        for (unsigned level = kLevels - 1; level > 0; level--) {
+          if ((now_ & ((int64_t{1} << (kSlotBits * level)) - 1)) == 0)
+            cascade(level);
+        }
+      }
+      fire_slot(static_cast<size_t>(now_) & (kSlots - 1), fire);
+    }
+  }
+
+  int64_t now() const { return now_; }
+  size_t size() const { return size_; }
+  size_t capacity() const { return nodes_.size(); }
+
+  // Timers turned away because the pool was full.
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  static constexpr int32_t kNone = -1;
+
+  struct Node {
+    Timer timer;
+    int32_t next;
+  };
+
+  // Links node `n` into the slot for `deadline` (>= now_), relative to
+  // `now_`.
+  void insert(int32_t n, int64_t deadline) {
+    Node &node = nodes_[static_cast<size_t>(n)];
+    // Lowest level at which deadline and now share the parent period; the
+    // top level has no parent and takes anything less than a turn ahead.
+    unsigned level = 0;
+    while (level < kLevels - 1 && (deadline >> (kSlotBits * (level + 1))) !=
+                                      (now_ >> (kSlotBits * (level + 1)))) {
+      level++;
+    }
+    constexpr unsigned kTopShift = kSlotBits * (kLevels - 1);
+    size_t slot;
+    if (level == kLevels - 1 &&
+        (deadline >> kTopShift) - (now_ >> kTopShift) >=
+            static_cast<int64_t>(kSlots)) {
+      // Beyond the wheel's range: park in the top level's farthest slot;
+      // its cascade files the timer again from that tick.
+      slot = (static_cast<size_t>(now_ >> kTopShift) + kSlots - 1) &
+             (kSlots - 1);
+    } else {
+      slot =
+          static_cast<size_t>(deadline >> (kSlotBits * level)) & (kSlots - 1);
+    }
+    node.next = heads_[level][slot];
+    heads_[level][slot] = n;
+    occupied_[level] |= uint64_t{1} << slot;
+  }
+
+  int32_t take(unsigned level, size_t slot) {
+    int32_t head = heads_[level][slot];
+    heads_[level][slot] = kNone;
+    occupied_[level] &= ~(uint64_t{1} << slot);
+    return head;
+  }
+
+  // Re-files the current slot of `level` into the levels below.
+  void cascade(unsigned level) {
+    size_t slot = static_cast<size_t>(now_ >> (kSlotBits * level)) &
+                  (kSlots - 1);
+    for (int32_t n = take(level, slot); n != kNone;) {
+      const Node &node = nodes_[static_cast<size_t>(n)];
+      int32_t next = node.next;
+      // A timer scheduled late (deadline already past) was filed one tick
+      // ahead; keep it at the current tick.
+      insert(n, std::max(node.timer.deadline, now_));
+      n = next;
+    }
+  }
+
+  template <typename F> void fire_slot(size_t slot, F &fire) {
+    for (int32_t n = take(0, slot); n != kNone;) {
+      Node &node = nodes_[static_cast<size_t>(n)];
+      int32_t next = node.next;
+      Timer timer = node.timer;
+      node.next = free_;
+      free_ = n;
+      size_--;
+      fire(timer);
+      n = next;
+    }
+  }
+
+  std::vector<Node> nodes_;
+  int32_t free_ = kNone;
+  int32_t heads_[kLevels][kSlots];
+  uint64_t occupied_[kLevels];
+  int64_t now_ = 0;
+  size_t size_ = 0;
+  uint64_t dropped_ = 0;
+};
@@ -0,0 +1,164 @@
+#include "analytics/track_lifecycle.h"
+
+#include <iostream>
+
+namespace {
+
+AnalyticsEvent event_of(EventType type, const TrackState &state,
+                        int32_t source_id, int32_t frame_num) {
+  AnalyticsEvent event{};
+  event.type = type;
+  event.source_id = source_id;
+  event.frame_num = frame_num;
+  event.track_id = state.track_id;
+  event.class_id = state.class_id;
+  return event;
+}
+
+} // namespace
+
+TrackLifecycle::TrackLifecycle(const Config &cfg, size_t max_tracks)
+    // An expiry timer per track, plus loitering timers and timers of
+    // erased tracks that have not come up yet.
+    : wheel_(max_tracks * 2),
+      expire_frames_(cfg.analytics.track_expire_frames),
+      fps_(cfg.analytics.fps) {}
+
+void TrackLifecycle::advance(TrackTable &tracks, int32_t source_id,
+                             int32_t frame_num, EventBuffer &events) {
+  if (frame_num == kNoFrameNum)
+    return; // no clock to move by
+  if (frame_num < wheel_.now() - fps_ && wheel_.size() > 0) {
+    // Frame numbers went back by more than a second: the producer
+    // restarted. Smaller steps back are late frames; the wheel ignores them.
+    tracks.clear();
+    wheel_.clear();
+    restarts_++;
+  }
+  wheel_.advance(frame_num, [&](const Timer &timer) {
+    fire(timer, tracks, source_id, events);
+  });
+}
+
+void TrackLifecycle::fire(const Timer &timer, TrackTable &tracks,
+                          int32_t source_id, EventBuffer &events) {
+  TrackState *state = tracks.find(timer.track_id);
+  auto now = static_cast<int32_t>(wheel_.now());
+
+  if (timer.kind == kExpire) {
+    if (state == nullptr || state->first_frame != timer.tag)
+      return; // erased (TTL sweep, restart) since
+    int64_t due = int64_t{state->last_frame} + expire_frames_;
+    if (due > now) {
+      wheel_.schedule(Timer{due, timer.track_id, timer.tag, 0, kExpire});
+      return;
+    }
+    end_track(*state, source_id, now, events);
+    tracks.erase(timer.track_id);
+    return;
+  }
+
+  // kLoiter: still in the same visit of the zone?
+  if (state == nullptr)
+    return;
+  const ZoneDwell &dwell = state->dwell;
+  for (size_t s = 0; s < ZoneDwell::kSlots; s++) {
+    if (dwell.zone[s] == timer.zone && dwell.since[s] == timer.tag) {
+      AnalyticsEvent event =
+          event_of(EventType::kLoitering, *state, source_id, now);
+      event.index = timer.zone;
+      event.value = now - dwell.since[s];
+      events.push(event);
+      loitering_++;
+      return;
+    }
+  }
+}
+
+void TrackLifecycle::end_track(TrackState &state, int32_t source_id,
+                               int32_t now, EventBuffer &events) {
+  for (uint64_t b = state.dwell.zones; b != 0; b &= b - 1) {
+    zone_exit(state, static_cast<size_t>(__builtin_ctzll(b)), state.last_frame,
+              source_id, now, events);
+  }
+  AnalyticsEvent event = event_of(EventType::kTrackEnd, state, source_id, now);
+  event.value = state.last_frame - state.first_frame;
+  events.push(event);
+  ended_++;
+  lifetime_frames_ += static_cast<uint64_t>(event.value);
+}
+
+void TrackLifecycle::zone_exit(TrackState &state, size_t zone, int32_t until,
+                               int32_t source_id, int32_t now,
+                               EventBuffer &events) {
+  ZoneDwell &dwell = state.dwell;
+  AnalyticsEvent event = event_of(EventType::kZoneExit, state, source_id, now);
+  event.index = static_cast<uint16_t>(zone);
+  event.value = -1; // entered while kSlots other zones were held
+  for (size_t s = 0; s < ZoneDwell::kSlots; s++) {
+    if (dwell.zone[s] == zone) {
+      event.value = until - dwell.since[s];
+      dwell.zone[s] = ZoneDwell::kFree;
+      break;
+    }
+  }
+  dwell.zones &= ~(uint64_t{1} << zone);
+  events.push(event);
+}
+
+void TrackLifecycle::zones_changed(TrackState &state, uint64_t inside,
+                                   const ZoneSet &zones, int32_t source_id,
+                                   int32_t frame_num, EventBuffer &events) {
+  ZoneDwell &dwell = state.dwell;
+  for (uint64_t b = dwell.zones & ~inside; b != 0; b &= b - 1) {
+    zone_exit(state, static_cast<size_t>(__builtin_ctzll(b)), frame_num,
+              source_id, frame_num, events);
+  }
+
+  for (uint64_t b = inside & ~dwell.zones; b != 0; b &= b - 1) {
+    auto zone = static_cast<size_t>(__builtin_ctzll(b));
+    dwell.zones |= uint64_t{1} << zone;
+    for (size_t s = 0; s < ZoneDwell::kSlots; s++) {
+      if (dwell.zone[s] != ZoneDwell::kFree)
+        continue;
+      dwell.zone[s] = static_cast<uint8_t>(zone);
+      dwell.since[s] = frame_num;
+      int32_t loiter = zones.loiter_frames(zone);
+      if (loiter > 0) {
+        wheel_.schedule(Timer{int64_t{frame_num} + loiter, state.track_id,
+                              frame_num, static_cast<uint16_t>(zone),
+                              kLoiter});
+      }
+      break;
+    }
+    AnalyticsEvent event =
+        event_of(EventType::kZoneEnter, state, source_id, frame_num);
+    event.index = static_cast<uint16_t>(zone);
+    events.push(event);
+  }
+}
+
+void TrackLifecycle::print_interval(int worker, int32_t source_id) {
+  if (ended_ == 0 && loitering_ == 0 && restarts_ == 0 && wheel_.size() == 0)
+    return;
+  std::cerr << "[TRACK]";
+  if (worker >= 0)
+    std::cerr << " w" << worker;
+  std::cerr << " source " << source_id << ": ended " << ended_;
+  if (ended_ > 0) {
+    std::cerr << " (avg lifetime "
+              << static_cast<double>(lifetime_frames_) / ended_ / fps_
+              << " s)";
+  }
+  std::cerr << ", loitering " << loitering_ << ", timers " << wheel_.size()
+            << "/" << wheel_.capacity();
+  if (wheel_.dropped() > 0)
+    std::cerr << ", dropped " << wheel_.dropped();
+  if (restarts_ > 0)
+    std::cerr << ", restarts " << restarts_;
+  std::cerr << "\n";
+  ended_ = 0;
+  lifetime_frames_ = 0;
+  loitering_ = 0;
+  restarts_ = 0;
+}
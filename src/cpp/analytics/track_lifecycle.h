@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "analytics/events.h"
+#include "analytics/timing_wheel.h"
+#include "analytics/track_table.h"
+#include "analytics/zones.h"
+#include "common/config.h"
+
+// ================= Track lifecycle =================
+//
+// Detections never say a track has ended; it just stops appearing. Per
+// source, a TimingWheel ticking on frame_num holds one expiry timer per
+// track and one loitering timer per (track, zone) visit, so ending tracks
+// and raising alerts costs O(1) per timer instead of a table scan per frame.
+//
+// Timers are not moved when a track is seen again. When an expiry timer
+// fires, the track's last_frame decides: re-arm at last_frame + expiry, or
+// end the track (zone exits with dwell, a track-end event, erase). Each
+// timer carries a tag (the track's first_frame, or the zone entry frame)
+// so timers left behind by an erased track, or an earlier visit, are
+// recognized and ignored.
+//
+// Time is the source's own frame clock: `[tracks] expire_ms` and zone
+// `loiter_ms` are converted with `[stream] fps`, and nothing expires while a
+// source sends nothing. Frame numbers going back by more than a second
+// (producer restart) start the source over; frames without a frame number
+// (empty JSON frames) leave the clock alone.
+
+class TrackLifecycle {
+public:
+  // `max_tracks` bounds the tracks of this source (the track table's
+  // capacity); the timer pool is sized from it.
+  TrackLifecycle(const Config &cfg, size_t max_tracks);
+
+  // ---------- hot path ----------
+
+  // Moves to `frame_num`, ending expired tracks and raising loitering
+  // alerts; a no-op for kNoFrameNum. Call before observing the frame's
+  // detections.
+  void advance(TrackTable &tracks, int32_t source_id, int32_t frame_num,
+               EventBuffer &events);
+
+  // Arms expiry for a track just inserted into the table.
+  void track_started(const TrackState &state) {
+    if (expire_frames_ > 0) {
+      wheel_.schedule(Timer{int64_t{state.first_frame} + expire_frames_,
+                            state.track_id, state.first_frame, 0, kExpire});
+    }
+  }
+
+  // Updates the zones `state` is in from `inside` (zone bits, already
+  // filtered by class), emitting enter / exit events.
+  void update_zones(TrackState &state, uint64_t inside, const ZoneSet &zones,
+                    int32_t source_id, int32_t frame_num,
+                    EventBuffer &events) {
+    if (inside != state.dwell.zones)
+      zones_changed(state, inside, zones, source_id, frame_num, events);
+  }
+
+  // ---------- cold path ----------
+
+  // Prints tracks ended since the last call and the wheel's load.
+  void print_interval(int worker, int32_t source_id);
+
+private:
+  enum TimerKind : uint8_t { kExpire, kLoiter };
+
+  void zones_changed(TrackState &state, uint64_t inside, const ZoneSet &zones,
+                     int32_t source_id, int32_t frame_num,
+                     EventBuffer &events);
+  void fire(const Timer &timer, TrackTable &tracks, int32_t source_id,
+            EventBuffer &events);
+  void end_track(TrackState &state, int32_t source_id, int32_t now,
+                 EventBuffer &events);
+  // Leaves `zone`; dwell runs from entry to `until`.
+  void zone_exit(TrackState &state, size_t zone, int32_t until,
+                 int32_t source_id, int32_t now, EventBuffer &events);
+
+  TimingWheel wheel_;
+  int32_t expire_frames_;
+  int fps_;
+
+  // Interval stats.
+  uint64_t ended_ = 0;
+  uint64_t lifetime_frames_ = 0;
+  uint64_t loitering_ = 0;
+  uint64_t restarts_ = 0;
+};
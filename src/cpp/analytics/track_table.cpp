@@ -0,0 +1,162 @@
+#include "analytics/track_table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// One alpha-beta step for every slot measured at `frame_num` after its
+// last update (`filtered`). Other slots are computed too and blended out
+// (x 0 + old x 1, exact for finite values) rather than selected, which GCC
+// will not vectorize around possibly trapping float ops. Empty slots hold
+// stale, finite data.
+void alpha_beta_step(const float *__restrict meas_x,
+                     const float *__restrict meas_y, float *__restrict pos_x,
+                     float *__restrict pos_y, float *__restrict vel_x,
+                     float *__restrict vel_y,
+                     const int32_t *__restrict measured,
+                     int32_t *__restrict filtered, size_t n, int32_t frame_num,
+                     float alpha, float beta) {
+  for (size_t i = 0; i < n; i++) {
+    int32_t gap = frame_num - filtered[i];
+    int32_t update = (measured[i] == frame_num) & (gap > 0);
+    auto m = static_cast<float>(update);
+    float keep = 1.0f - m;
+    auto dt = static_cast<float>(gap > 0 ? gap : 1);
+    // Predict over the frames since the last update, then correct toward
+    // the measurement.
+    float px = pos_x[i] + vel_x[i] * dt;
+    float py = pos_y[i] + vel_y[i] * dt;
+    float rx = meas_x[i] - px;
+    float ry = meas_y[i] - py;
+    float gain = beta / dt;
+    pos_x[i] = m * (px + alpha * rx) + keep * pos_x[i];
+    pos_y[i] = m * (py + alpha * ry) + keep * pos_y[i];
+    vel_x[i] = m * (vel_x[i] + gain * rx) + keep * vel_x[i];
+    vel_y[i] = m * (vel_y[i] + gain * ry) + keep * vel_y[i];
+    filtered[i] += update * gap;
+  }
+}
+
+} // namespace
+
+TrackTable::TrackTable(size_t expected_tracks, int ttl_frames, float alpha,
+                       float beta)
+    : ttl_frames_(std::max(1, ttl_frames)), alpha_(alpha), beta_(beta) {
+  size_t capacity = 16;
+  unsigned bits = 4;
+  while (capacity < expected_tracks * 4) {
+    capacity <<= 1;
+    bits++;
+  }
+  mask_ = capacity - 1;
+  shift_ = 32 - bits;
+  max_load_ = capacity / 2;
+
+  keys_ = make_aligned_array<int32_t>(capacity);
+  states_ = make_aligned_array<TrackState>(capacity);
+  std::fill_n(keys_.get(), capacity, kEmpty);
+
+  if (has_motion()) {
+    stride_ = capacity;
+    motion_ = make_aligned_array<float>(kColumns * stride_);
+    frames_ = make_aligned_array<int32_t>(2 * stride_);
+  }
+}
+
+bool TrackTable::erase(int32_t track_id) {
+  if (track_id == kEmpty)
+    return false;
+  for (size_t i = home(track_id); keys_[i] != kEmpty; i = (i + 1) & mask_) {
+    if (keys_[i] == track_id) {
+      erase_slot(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+void TrackTable::clear() {
+  std::fill_n(keys_.get(), capacity(), kEmpty);
+  size_ = 0;
+}
+
+void TrackTable::erase_slot(size_t i) {
+  // Pull later members of the probe chain back into the hole, as long as
+  // that does not move them before their home slot.
+  size_t hole = i;
+  for (size_t j = (i + 1) & mask_; keys_[j] != kEmpty; j = (j + 1) & mask_) {
+    size_t want = home(keys_[j]);
+    // Entry j may fill the hole if its home is not in (hole, j].
+    if (((j - want) & mask_) >= ((j - hole) & mask_)) {
+      keys_[hole] = keys_[j];
+      states_[hole] = states_[j];
+      if (has_motion()) {
+        for (size_t c = 0; c < kColumns; c++) {
+          motion_[c * stride_ + hole] = motion_[c * stride_ + j];
+        }
+        frames_[kMeasured * stride_ + hole] = frames_[kMeasured * stride_ + j];
+        frames_[kFiltered * stride_ + hole] = frames_[kFiltered * stride_ + j];
+      }
+      hole = j;
+    }
+  }
+  keys_[hole] = kEmpty;
+  size_--;
+}
+
+size_t TrackTable::evict_older_than(int32_t frame_num) {
+  size_t evicted = 0;
+  size_t i = 0;
+  while (i <= mask_) {
+    // erase_slot may pull a later entry into slot i; look at it again.
+    if (keys_[i] != kEmpty && states_[i].last_frame < frame_num) {
+      erase_slot(i);
+      evicted++;
+      continue;
+    }
+    i++;
+  }
+  return evicted;
+}
+
+void TrackTable::update_motion(int32_t frame_num) {
+  float *m = motion_.get();
+  int32_t *f = frames_.get();
+  alpha_beta_step(m + kMeasX * stride_, m + kMeasY * stride_,
+                  m + kPosX * stride_, m + kPosY * stride_,
+                  m + kVelX * stride_, m + kVelY * stride_,
+                  f + kMeasured * stride_, f + kFiltered * stride_, stride_,
+                  frame_num, alpha_, beta_);
+}
+
+void TrackTable::print_motion(int worker, int32_t source_id, int fps) const {
+  size_t moving = 0;
+  double sum = 0.0;
+  float fastest = 0.0f;
+  int32_t fastest_id = kEmpty;
+  for (size_t i = 0; i <= mask_; i++) {
+    if (keys_[i] == kEmpty || states_[i].hits < 2)
+      continue;
+    float speed = std::hypot(motion_[kVelX * stride_ + i],
+                             motion_[kVelY * stride_ + i]);
+    moving++;
+    sum += speed;
+    if (speed > fastest) {
+      fastest = speed;
+      fastest_id = keys_[i];
+    }
+  }
+  std::cerr << "[MOTION]";
+  if (worker >= 0)
+    std::cerr << " w" << worker;
+  std::cerr << " source " << source_id << ": " << moving
+            << " tracks, mean speed "
+            << (moving > 0 ? sum / moving * fps : 0.0) << " px/s";
+  if (fastest_id != kEmpty) {
+    std::cerr << ", fastest track " << fastest_id << " at "
+              << fastest * static_cast<float>(fps) << " px/s";
+  }
+  std::cerr << "\n";
+}
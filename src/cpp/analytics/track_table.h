@@ -0,0 +1,229 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "analytics/aligned.h"
+#include "analytics/frame.h"
+
+// Zones a track is in and when it entered them (see track_lifecycle.h).
+// Dwell is kept for up to kSlots zones at once; further overlapping zones
+// still get enter / exit events, but no dwell time or loitering alert.
+struct ZoneDwell {
+  static constexpr size_t kSlots = 4;
+  static constexpr uint8_t kFree = 0xff;
+
+  uint64_t zones;        // bit per zone index
+  uint8_t zone[kSlots];  // zone index or kFree
+  int32_t since[kSlots]; // frame_num of entry
+};
+
+// What the consumer remembers about one track of one source.
+struct TrackState {
+  int32_t track_id;
+  int32_t class_id;    // latest
+  int32_t first_frame; // frame_num when first seen
+  int32_t last_frame;  // frame_num when last seen
+  uint32_t hits;       // detections observed
+  BBox last_bbox;
+  ZoneDwell dwell;
+  uint64_t rules; // bit per rule currently true (see rules.h)
+};
+
+// Smoothed bbox bottom-centre and velocity (pixels per frame) of one track.
+struct TrackMotion {
+  float x, y;
+  float vx, vy;
+};
+
+enum class TrackLookup {
+  kHit,     // track already known
+  kMiss,    // new track, inserted
+  kDropped, // table full of live tracks (or reserved id); not stored
+};
+
+// Per-source track table keyed by `track_id`: open addressing with linear
+// probing, no per-entry allocation.
+//
+// Keys and states are separate cache-line-aligned arrays, so a probe walks
+// 16 keys per line and only the matching state is touched. Capacity is fixed
+// at construction (a power of two, at least 4 x `expected_tracks`, kept at
+// most half full). When an insert would pass that, tracks not seen for
+// `ttl_frames` are swept out first; erasure uses backward-shift deletion, so
+// there are no tombstones and probe chains stay short.
+//
+// With motion on (`alpha > 0`), each slot also has an alpha-beta filter on
+// the bbox bottom-centre, in SoA columns beside the states. `observe` only
+// stores the measurement; `update_motion` then filters every track measured
+// on the frame in one branch-free pass over the columns (masked per slot,
+// auto-vectorized), rather than one scattered update per detection.
+class TrackTable {
+public:
+  // Never a valid key; `track_id == kEmpty` detections are not tracked.
+  static constexpr int32_t kEmpty = std::numeric_limits<int32_t>::min();
+
+  // `alpha` / `beta`: motion filter gains; alpha 0 = no motion state.
+  TrackTable(size_t expected_tracks, int ttl_frames, float alpha = 0.0f,
+             float beta = 0.0f);
+
+  // ---------- hot path ----------
+
+  struct Observation {
+    TrackLookup lookup;
+    BBox previous;     // bbox before this update; `det.bbox` if not a hit
+    TrackState *state; // null if dropped; valid until the next insert/erase
+  };
+
+  // Finds or inserts `det.track_id` and updates its state from `det`. A
+  // detection from before the track's last frame is only counted; it
+  // leaves the state as is and its `previous` is `det.bbox`.
+  Observation observe(const Detection &det, int32_t frame_num) {
+    int32_t id = det.track_id;
+    if (id == kEmpty)
+      return {TrackLookup::kDropped, det.bbox, nullptr};
+
+    size_t i = home(id);
+    while (keys_[i] != kEmpty) {
+      if (keys_[i] == id) {
+        TrackState &state = states_[i];
+        if (frame_num < state.last_frame) {
+          // Late: moving the track back would make it cross lines twice.
+          state.hits++;
+          return {TrackLookup::kHit, det.bbox, &state};
+        }
+        BBox previous = state.last_bbox;
+        state.class_id = det.class_id;
+        state.last_frame = frame_num;
+        state.last_bbox = det.bbox;
+        state.hits++;
+        if (has_motion())
+          measure(i, det.bbox, frame_num);
+        return {TrackLookup::kHit, previous, &state};
+      }
+      i = (i + 1) & mask_;
+    }
+
+    if (size_ >= max_load_) {
+      if (evict_older_than(frame_num - ttl_frames_) == 0) {
+        dropped_++;
+        return {TrackLookup::kDropped, det.bbox, nullptr};
+      }
+      // Eviction may have shifted keys; find the slot again.
+      i = home(id);
+      while (keys_[i] != kEmpty)
+        i = (i + 1) & mask_;
+    }
+
+    keys_[i] = id;
+    TrackState &state = states_[i];
+    state = TrackState{id, det.class_id, frame_num, frame_num, 1, det.bbox,
+                       ZoneDwell{}, 0};
+    std::fill_n(state.dwell.zone, ZoneDwell::kSlots, ZoneDwell::kFree);
+    if (has_motion())
+      start_motion(i, det.bbox, frame_num);
+    size_++;
+    return {TrackLookup::kMiss, det.bbox, &state};
+  }
+
+  TrackState *find(int32_t track_id) {
+    if (track_id == kEmpty)
+      return nullptr;
+    for (size_t i = home(track_id); keys_[i] != kEmpty; i = (i + 1) & mask_) {
+      if (keys_[i] == track_id)
+        return &states_[i];
+    }
+    return nullptr;
+  }
+  const TrackState *find(int32_t track_id) const {
+    return const_cast<TrackTable *>(this)->find(track_id);
+  }
+
+  bool has_motion() const { return alpha_ > 0.0f; }
+
+  // Runs the motion filter for every track measured at `frame_num` since
+  // the last call. Call once per frame, after observing its detections.
+  void update_motion(int32_t frame_num);
+
+  // Motion of a track of this table (`has_motion()` only); before
+  // `update_motion`, as of the track's previous frame.
+  TrackMotion motion(const TrackState &state) const {
+    auto i = static_cast<size_t>(&state - states_.get());
+    const float *m = motion_.get();
+    return {m[kPosX * stride_ + i], m[kPosY * stride_ + i],
+            m[kVelX * stride_ + i], m[kVelY * stride_ + i]};
+  }
+
+  // ---------- cold path ----------
+
+  bool erase(int32_t track_id);
+
+  // Removes every track.
+  void clear();
+
+  // Removes tracks last seen before `frame_num`; returns how many.
+  size_t evict_older_than(int32_t frame_num);
+
+  // Prints how many tracks move and how fast (`has_motion()` only).
+  void print_motion(int worker, int32_t source_id, int fps) const;
+
+  template <typename F> void for_each(F &&fn) const {
+    for (size_t i = 0; i <= mask_; i++) {
+      if (keys_[i] != kEmpty)
+        fn(states_[i]);
+    }
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return mask_ + 1; }
+
+  // New tracks turned away because the table was full of live ones.
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  // Fibonacci hashing: spreads sequential and strided ids alike.
+  size_t home(int32_t id) const {
+    return (static_cast<uint32_t>(id) * 0x9E3779B9u) >> shift_;
+  }
+
+  // Backward-shift delete of the entry in slot `i`.
+  void erase_slot(size_t i);
+
+  // Motion columns, `stride_` floats each; frames in `frames_`.
+  enum MotionColumn { kMeasX, kMeasY, kPosX, kPosY, kVelX, kVelY, kColumns };
+  enum MotionFrame { kMeasured, kFiltered };
+
+  void measure(size_t i, const BBox &bbox, int32_t frame_num) {
+    float *m = motion_.get();
+    m[kMeasX * stride_ + i] = bbox.left + 0.5f * bbox.width;
+    m[kMeasY * stride_ + i] = bbox.top + bbox.height;
+    frames_[kMeasured * stride_ + i] = frame_num;
+  }
+
+  // A new track starts where it is seen, at rest.
+  void start_motion(size_t i, const BBox &bbox, int32_t frame_num) {
+    measure(i, bbox, frame_num);
+    float *m = motion_.get();
+    m[kPosX * stride_ + i] = m[kMeasX * stride_ + i];
+    m[kPosY * stride_ + i] = m[kMeasY * stride_ + i];
+    m[kVelX * stride_ + i] = 0.0f;
+    m[kVelY * stride_ + i] = 0.0f;
+    frames_[kFiltered * stride_ + i] = frame_num;
+  }
+
+  size_t mask_;
+  unsigned shift_;
+  size_t max_load_;
+  int32_t ttl_frames_;
+  size_t size_ = 0;
+  uint64_t dropped_ = 0;
+
+  AlignedArray<int32_t> keys_;
+  AlignedArray<TrackState> states_;
+
+  float alpha_;
+  float beta_;
+  size_t stride_ = 0;            // capacity when motion is on
+  AlignedArray<float> motion_;   // kColumns x stride_
+  AlignedArray<int32_t> frames_; // {measured, filtered} x stride_
+};
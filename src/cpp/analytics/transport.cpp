@@ -0,0 +1,32 @@
+#include "analytics/transport.h"
+
+#include <iostream>
+
+zmq::socket_t open_consumer_socket(zmq::context_t &ctx, const ZmqConfig &cfg) {
+  zmq::socket_t socket(ctx, cfg.socket_type == SocketType::kPull
+                                ? zmq::socket_type::pull
+                                : zmq::socket_type::sub);
+
+  socket.set(zmq::sockopt::rcvhwm, cfg.rcvhwm);
+  if (cfg.socket_type == SocketType::kSub)
+    socket.set(zmq::sockopt::subscribe, cfg.subscribe);
+
+  if (cfg.bind) {
+    socket.bind(cfg.endpoint);
+    std::cout << "Bound to " << cfg.endpoint << "\n";
+  } else {
+    socket.connect(cfg.endpoint);
+    std::cout << "Connected to " << cfg.endpoint << "\n";
+  }
+  return socket;
+}
+
+zmq::socket_t open_publisher_socket(zmq::context_t &ctx,
+                                    const EventConfig &cfg) {
+  zmq::socket_t socket(ctx, zmq::socket_type::pub);
+  socket.set(zmq::sockopt::sndhwm, cfg.publish_hwm);
+  socket.set(zmq::sockopt::linger, 100); // ms; bounds the wait at exit
+  socket.bind(cfg.publish);
+  std::cout << "Publishing events on " << cfg.publish << "\n";
+  return socket;
+}
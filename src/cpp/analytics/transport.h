@@ -0,0 +1,18 @@
+#pragma once
+#include "common/config.h"
+#include <zmq.hpp>
+
+// Opens the consumer socket described by `[zmq]`:
+//
+//   socket_type  "sub"  — subscribe to `subscribe` on a PUB producer
+//                "pull" — load-balanced fan-out from a PUSH producer; run
+//                         several consumers to share one stream
+//   bind         connect (default) or bind `endpoint`
+//   endpoint     tcp:// or ipc:// (same host, no TCP loopback stack)
+zmq::socket_t open_consumer_socket(zmq::context_t &ctx, const ZmqConfig &cfg);
+
+// Binds the PUB socket for `[events] publish` (see publisher.h). Subscribers
+// connect to it; a slow one only fills its own queue up to `publish_hwm`,
+// past which ZMQ drops its messages.
+zmq::socket_t open_publisher_socket(zmq::context_t &ctx,
+                                    const EventConfig &cfg);
@@ -0,0 +1,149 @@
+#include "analytics/tripwires.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Writes a crossing code per point for the line a -> b; returns the OR of
+// all codes, so a frame nobody crossed is rejected without a second pass.
+// p = previous anchors, c = current anchors.
+//
+// Side of q: cross(b - a, q - a) > 0 is right of a -> b in image
+// coordinates (y down). A crossing needs the side to change (d1 vs d2) and
+// a, b to lie on different sides of the track's step p -> c (d3 vs d4).
+uint8_t test_crossings(const float *__restrict px, const float *__restrict py,
+                       const float *__restrict cx, const float *__restrict cy,
+                       size_t n, float ax, float ay, float bx, float by,
+                       uint8_t *__restrict out) {
+  const float ex = bx - ax;
+  const float ey = by - ay;
+  uint8_t any = 0;
+  for (size_t i = 0; i < n; i++) {
+    float d1 = ex * (py[i] - ay) - ey * (px[i] - ax);
+    float d2 = ex * (cy[i] - ay) - ey * (cx[i] - ax);
+    float mx = cx[i] - px[i];
+    float my = cy[i] - py[i];
+    float d3 = mx * (ay - py[i]) - my * (ax - px[i]);
+    float d4 = mx * (by - py[i]) - my * (bx - px[i]);
+    int to_right = (d1 <= 0.0f) & (d2 > 0.0f);
+    int to_left = (d1 > 0.0f) & (d2 <= 0.0f);
+    int straddles = d3 * d4 <= 0.0f;
+    auto code = static_cast<uint8_t>((to_right | (to_left << 1)) & -straddles);
+    out[i] = code;
+    any |= code;
+  }
+  return any;
+}
+
+} // namespace
+
+TripwireSet::TripwireSet(const Config &cfg, int32_t source_id)
+    : num_classes_(static_cast<size_t>(cfg.analytics.num_classes)),
+      row_(num_classes_ + 1) {
+  for (const auto &wc : cfg.tripwires) {
+    if (wc.source_id != source_id)
+      continue;
+    if (wires_.size() == kMaxTripwires) {
+      std::cerr << "[LINE] source " << source_id << ": more than "
+                << kMaxTripwires << " tripwires, ignoring " << wc.name << "\n";
+      continue;
+    }
+
+    Wire wire{};
+    wire.name = wc.name;
+    wire.ax = wc.from.first;
+    wire.ay = wc.from.second;
+    wire.bx = wc.to.first;
+    wire.by = wc.to.second;
+    switch (wc.direction) {
+    case TripwireDirection::kBoth:
+      wire.directions = kCrossIn | kCrossOut;
+      break;
+    case TripwireDirection::kIn:
+      wire.directions = kCrossIn;
+      break;
+    case TripwireDirection::kOut:
+      wire.directions = kCrossOut;
+      break;
+    }
+    wire.all_classes = wc.classes.empty();
+    for (int c : wc.classes) {
+      if (c < 256)
+        wire.class_mask[c / 64] |= uint64_t{1} << (c % 64);
+    }
+    wires_.push_back(std::move(wire));
+  }
+
+  cross_ = make_aligned_array<uint8_t>(round_up_to_line<uint8_t>(
+      static_cast<size_t>(std::max(1, cfg.analytics.max_detections))));
+  counts_.assign(wires_.size() * row_ * 2, 0);
+  interval_.assign(wires_.size() * 2, 0);
+}
+
+void TripwireSet::evaluate(const FrameColumns &frame, EventBuffer &events) {
+  size_t n = frame.size();
+  const int32_t *track = frame.track_id();
+  const int32_t *cls = frame.class_id();
+  uint8_t *cross = cross_.get();
+
+  for (size_t w = 0; w < wires_.size(); w++) {
+    const Wire &wire = wires_[w];
+    uint8_t any = test_crossings(frame.prev_anchor_x(), frame.prev_anchor_y(),
+                                 frame.anchor_x(), frame.anchor_y(), n,
+                                 wire.ax, wire.ay, wire.bx, wire.by, cross);
+    if ((any & wire.directions) == 0)
+      continue;
+
+    for (size_t i = 0; i < n; i++) {
+      uint8_t code = cross[i] & wire.directions;
+      if (code == 0 || !counts(wire, cls[i]))
+        continue;
+      auto bucket = static_cast<size_t>(cls[i]);
+      size_t row = cls[i] >= 0 && bucket < num_classes_ ? bucket : num_classes_;
+      size_t dir = code == kCrossIn ? 0 : 1;
+      counts_[(w * row_ + row) * 2 + dir]++;
+      interval_[w * 2 + dir]++;
+
+      AnalyticsEvent event{};
+      event.type = EventType::kLineCrossing;
+      event.direction = code == kCrossIn ? 1 : -1;
+      event.index = static_cast<uint16_t>(w);
+      event.source_id = frame.source_id();
+      event.frame_num = frame.frame_num();
+      event.track_id = track[i];
+      event.class_id = cls[i];
+      events.push(event);
+    }
+  }
+}
+
+void TripwireSet::print_interval(int worker, int32_t source_id) {
+  for (size_t w = 0; w < wires_.size(); w++) {
+    std::cerr << "[LINE]";
+    if (worker >= 0)
+      std::cerr << " w" << worker;
+    std::cerr << " source " << source_id << " " << wires_[w].name << ": +"
+              << interval_[w * 2] << " in, +" << interval_[w * 2 + 1]
+              << " out; total";
+    uint64_t total_in = 0;
+    uint64_t total_out = 0;
+    for (size_t c = 0; c < row_; c++) {
+      uint64_t in = crossings_in(w, c);
+      uint64_t out = crossings_out(w, c);
+      total_in += in;
+      total_out += out;
+      if (in == 0 && out == 0)
+        continue;
+      if (c == num_classes_) {
+        std::cerr << " other:";
+      } else {
+        std::cerr << " " << c << ":";
+      }
+      std::cerr << in << "/" << out;
+    }
+    std::cerr << " all:" << total_in << "/" << total_out << "\n";
+    interval_[w * 2] = 0;
+    interval_[w * 2 + 1] = 0;
+  }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "analytics/aligned.h"
+#include "analytics/events.h"
+#include "analytics/frame_columns.h"
+#include "common/config.h"
+
+// ================= Tripwires =================
+//
+// Counting lines on one source (`[[tripwires]]` in config.toml). A track
+// crosses a line when the segment from its previous anchor to its current
+// one intersects the line segment; the side it ends up on gives the
+// direction (`in`: left of from -> to to its right, as drawn on the image).
+//
+// Each line is tested against every detection of a frame in one branch-free
+// loop over the anchor columns (auto-vectorized), producing a crossing code
+// per detection; only the few non-zero codes are then counted and turned
+// into events. New tracks have previous == current, so they never cross.
+// Counters are running totals per line, class and direction.
+
+class TripwireSet {
+public:
+  // Most lines one source may have; event indices are uint16_t.
+  static constexpr size_t kMaxTripwires = 64;
+
+  // Lines of `source_id` from `cfg.tripwires`.
+  TripwireSet(const Config &cfg, int32_t source_id);
+
+  // No lines.
+  TripwireSet() = default;
+
+  size_t size() const { return wires_.size(); }
+  const std::string &name(size_t wire) const { return wires_[wire].name; }
+
+  // ---------- hot path ----------
+
+  // Tests every detection's previous -> current anchor against every line,
+  // updates the counters and appends crossing events to `events`.
+  void evaluate(const FrameColumns &frame, EventBuffer &events);
+
+  // Running total for `wire`; `cls` in [0, num_classes], num_classes being
+  // the "other" bucket.
+  uint64_t crossings_in(size_t wire, size_t cls) const {
+    return counts_[(wire * row_ + cls) * 2];
+  }
+  uint64_t crossings_out(size_t wire, size_t cls) const {
+    return counts_[(wire * row_ + cls) * 2 + 1];
+  }
+
+  // ---------- cold path ----------
+
+  // Prints crossings since the last call and running totals.
+  void print_interval(int worker, int32_t source_id);
+
+private:
+  // Per-detection result of one line test.
+  static constexpr uint8_t kCrossIn = 1;
+  static constexpr uint8_t kCrossOut = 2;
+
+  struct Wire {
+    std::string name;
+    float ax, ay;           // from
+    float bx, by;           // to
+    uint8_t directions;     // kCrossIn | kCrossOut bits counted
+    uint64_t class_mask[4]; // classes counted, bit per id < 256
+    bool all_classes;
+  };
+
+  bool counts(const Wire &wire, int32_t cls) const {
+    if (wire.all_classes)
+      return true;
+    auto c = static_cast<uint32_t>(cls);
+    return c < 256 && ((wire.class_mask[c / 64] >> (c % 64)) & 1);
+  }
+
+  std::vector<Wire> wires_;
+  size_t num_classes_ = 0;
+  size_t row_ = 0; // num_classes + 1
+
+  AlignedArray<uint8_t> cross_;    // per detection, scratch
+  std::vector<uint64_t> counts_;   // wires x row x {in, out}, running
+  std::vector<uint64_t> interval_; // wires x {in, out}, since last print
+};
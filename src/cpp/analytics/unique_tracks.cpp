@@ -0,0 +1,123 @@
+#include "analytics/unique_tracks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "analytics/track_table.h"
+
+namespace {
+
+void tag(int worker) {
+  std::cerr << "[UNIQUE]";
+  if (worker >= 0)
+    std::cerr << " w" << worker;
+}
+
+long long rounded(const HyperLogLog &sketch) {
+  return std::llround(sketch.estimate());
+}
+
+} // namespace
+
+UniqueTracks::UniqueTracks(const Config &cfg)
+    : num_classes_(static_cast<size_t>(cfg.analytics.num_classes)),
+      all_(static_cast<unsigned>(cfg.analytics.hll_precision)),
+      hashes_(make_aligned_array<uint64_t>(round_up_to_line<uint64_t>(
+          static_cast<size_t>(std::max(1, cfg.analytics.max_detections))))) {
+  auto precision = static_cast<unsigned>(cfg.analytics.hll_precision);
+  size_t sources = static_cast<size_t>(std::max(1, cfg.analytics.max_sources));
+  by_source_.reserve(sources);
+  for (size_t i = 0; i < sources; i++) {
+    by_source_.emplace_back(precision);
+  }
+  by_class_.reserve(num_classes_ + 1);
+  for (size_t i = 0; i <= num_classes_; i++) {
+    by_class_.emplace_back(precision);
+  }
+}
+
+void UniqueTracks::add_frame(size_t slot, const FrameColumns &frame) {
+  size_t n = frame.size();
+  const int32_t *track = frame.track_id();
+  const int32_t *cls = frame.class_id();
+  uint64_t *hash = hashes_.get();
+
+  uint64_t source = uint64_t{static_cast<uint32_t>(frame.source_id())} << 32;
+  for (size_t i = 0; i < n; i++) {
+    hash[i] = hll_hash(source | static_cast<uint32_t>(track[i]));
+  }
+
+  Sketches &per_source = by_source_[slot];
+  for (size_t i = 0; i < n; i++) {
+    if (track[i] == TrackTable::kEmpty)
+      continue;
+    auto c = static_cast<size_t>(cls[i]);
+    Sketches &per_class = by_class_[cls[i] >= 0 && c < num_classes_
+                                        ? c
+                                        : num_classes_];
+    per_source.total.add(hash[i]);
+    per_source.interval.add(hash[i]);
+    per_class.total.add(hash[i]);
+    per_class.interval.add(hash[i]);
+  }
+}
+
+void UniqueTracks::print_interval(int worker, const SourceIndex &sources) {
+  all_.total.clear();
+  all_.interval.clear();
+  for (size_t slot = 0; slot < sources.size(); slot++) {
+    Sketches &s = by_source_[slot];
+    tag(worker);
+    std::cerr << " source " << sources.id(slot) << ": ~" << rounded(s.interval)
+              << " tracks this interval, ~" << rounded(s.total) << " total\n";
+    all_.total.merge(s.total);
+    all_.interval.merge(s.interval);
+    s.interval.clear();
+  }
+  if (sources.size() > 1) {
+    tag(worker);
+    std::cerr << " all sources: ~" << rounded(all_.interval)
+              << " tracks this interval, ~" << rounded(all_.total)
+              << " total\n";
+  }
+  for (size_t c = 0; c < by_class_.size(); c++) {
+    Sketches &s = by_class_[c];
+    long long total = rounded(s.total);
+    if (total > 0) {
+      tag(worker);
+      if (c == num_classes_) {
+        std::cerr << "   class other: ~";
+      } else {
+        std::cerr << "   class " << c << ": ~";
+      }
+      std::cerr << rounded(s.interval) << " this interval, ~" << total
+                << " total\n";
+    }
+    s.interval.clear();
+  }
+}
+
+void UniqueTracks::print_final(int worker, const SourceIndex &sources) const {
+  if (sources.size() == 0)
+    return;
+  HyperLogLog all(precision());
+  merge_into(all);
+  size_t sketches = 2 * (by_source_.size() + by_class_.size() + 1);
+  tag(worker);
+  std::cerr << " final: ~" << rounded(all) << " unique tracks over "
+            << sources.size() << " source(s), "
+            << sketches * all.size() / 1024 << " KiB of sketches\n";
+}
+
+long long UniqueTracks::estimate() const {
+  HyperLogLog all(precision());
+  merge_into(all);
+  return rounded(all);
+}
+
+void UniqueTracks::merge_into(HyperLogLog &out) const {
+  for (const auto &s : by_source_) {
+    out.merge(s.total);
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "analytics/frame_columns.h"
+#include "analytics/hyperloglog.h"
+#include "analytics/source_index.h"
+#include "common/config.h"
+
+// Distinct tracks per source and per class, since start and per report
+// interval, in HyperLogLog sketches instead of analyze.py's ever-growing
+// set. Memory is fixed at construction: two sketches (total, interval) per
+// source slot and per class bucket, 2^[uniques] precision bytes each.
+//
+// A track is keyed by (source_id, track_id), so the same id on two cameras
+// counts twice; each consumer's sketches merge into multi-source or
+// multi-worker totals (`merge_into`).
+class UniqueTracks {
+public:
+  explicit UniqueTracks(const Config &cfg);
+
+  // cppcheck-suppress functionStatic
+  bool enabled() const { return true; }
+
+  // ---------- hot path ----------
+
+  // Adds the tracked detections of `frame`, from source slot `slot`.
+  void add_frame(size_t slot, const FrameColumns &frame);
+
+  // ---------- cold path ----------
+
+  // Prints interval and total estimates per source, per class and for all
+  // sources; starts a new interval.
+  void print_interval(int worker, const SourceIndex &sources);
+
+  void print_final(int worker, const SourceIndex &sources) const;
+
+  // Distinct tracks since start over all sources.
+  long long estimate() const;
+
+  // Merges every source's total into `out` (same precision).
+  void merge_into(HyperLogLog &out) const;
+
+  unsigned precision() const { return all_.total.precision(); }
+
+private:
+  struct Sketches {
+    explicit Sketches(unsigned precision)
+        : total(precision), interval(precision) {}
+    HyperLogLog total;
+    HyperLogLog interval;
+  };
+
+  size_t num_classes_;
+  std::vector<Sketches> by_source_; // by source slot
+  std::vector<Sketches> by_class_;  // num_classes + 1 ("other")
+  Sketches all_;                    // merge scratch for reports
+  AlignedArray<uint64_t> hashes_;   // per-detection scratch
+};
@@ -0,0 +1,133 @@
+#include "analytics/windows.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+SlidingWindows::SlidingWindows(const Config &cfg)
+    : bucket_sec_(cfg.windows.bucket_sec),
+      classes_(static_cast<size_t>(cfg.analytics.num_classes) + 1),
+      sources_(static_cast<size_t>(std::max(1, cfg.analytics.max_sources))),
+      row_(kClassColumns * classes_ + kSourceColumns * sources_) {
+  for (int span : cfg.windows.spans_sec) {
+    spans_.push_back(static_cast<size_t>(
+        std::max(1, (span + bucket_sec_ - 1) / bucket_sec_)));
+  }
+  ring_ = spans_.empty() ? 1 : *std::max_element(spans_.begin(), spans_.end());
+  buckets_ = make_aligned_array<uint64_t>(ring_ * row_);
+  running_ = make_aligned_array<uint64_t>(std::max<size_t>(spans_.size(), 1) *
+                                          row_);
+}
+
+void SlidingWindows::advance(uint32_t buckets) {
+  if (buckets >= ring_) {
+    // Everything kept is older than the longest window.
+    std::memset(buckets_.get(), 0, ring_ * row_ * sizeof(uint64_t));
+    std::memset(running_.get(), 0, spans_.size() * row_ * sizeof(uint64_t));
+    closed_ += buckets;
+    return;
+  }
+  for (uint32_t b = 0; b < buckets; b++) {
+    const uint64_t *done = bucket(head_);
+    for (size_t w = 0; w < spans_.size(); w++) {
+      // A window is the current bucket plus its span - 1 newest closed
+      // ones; the closed bucket span - 1 back leaves it.
+      uint64_t *run = running_.get() + w * row_;
+      size_t span = spans_[w];
+      const uint64_t *gone =
+          closed_ + 1 >= span ? bucket((head_ + ring_ - (span - 1)) % ring_)
+                              : nullptr;
+      for (size_t k = 0; k < row_; k++) {
+        run[k] += done[k];
+      }
+      if (gone != nullptr) {
+        for (size_t k = 0; k < row_; k++) {
+          run[k] -= gone[k];
+        }
+      }
+    }
+    head_ = (head_ + 1) % ring_;
+    std::memset(bucket(head_), 0, row_ * sizeof(uint64_t));
+    closed_++;
+  }
+}
+
+uint64_t SlidingWindows::detections(size_t window, size_t cls) const {
+  return value(window, class_column(kClassDetections, cls));
+}
+
+double SlidingWindows::mean_confidence(size_t window, size_t cls) const {
+  uint64_t n = detections(window, cls);
+  return n > 0 ? static_cast<double>(value(
+                     window, class_column(kClassConfidence, cls))) /
+                     1e6 / static_cast<double>(n)
+               : 0.0;
+}
+
+uint64_t SlidingWindows::all_frames(size_t window) const {
+  uint64_t frames = 0;
+  for (size_t slot = 0; slot < sources_; slot++) {
+    frames += source_frames(window, slot);
+  }
+  return frames;
+}
+
+double SlidingWindows::occupancy(size_t window, size_t cls) const {
+  uint64_t frames = all_frames(window);
+  return frames > 0 ? static_cast<double>(detections(window, cls)) /
+                          static_cast<double>(frames)
+                    : 0.0;
+}
+
+uint64_t SlidingWindows::source_frames(size_t window, size_t slot) const {
+  return value(window, source_column(kSourceFrames, slot));
+}
+
+double SlidingWindows::source_occupancy(size_t window, size_t slot) const {
+  uint64_t frames = source_frames(window, slot);
+  return frames > 0 ? static_cast<double>(value(
+                          window, source_column(kSourceDetections, slot))) /
+                          static_cast<double>(frames)
+                    : 0.0;
+}
+
+double SlidingWindows::source_mean_confidence(size_t window,
+                                              size_t slot) const {
+  uint64_t n = value(window, source_column(kSourceDetections, slot));
+  return n > 0 ? static_cast<double>(
+                     value(window, source_column(kSourceConfidence, slot))) /
+                     1e6 / static_cast<double>(n)
+               : 0.0;
+}
+
+void SlidingWindows::print_interval(int worker,
+                                    const SourceIndex &sources) const {
+  for (size_t w = 0; w < spans_.size(); w++) {
+    auto tag = [&] {
+      std::cerr << "[WINDOW]";
+      if (worker >= 0)
+        std::cerr << " w" << worker;
+      std::cerr << " " << span_sec(w) << "s";
+    };
+    for (size_t slot = 0; slot < sources.size(); slot++) {
+      tag();
+      std::cerr << " source " << sources.id(slot) << ": frames "
+                << source_frames(w, slot) << ", objects/frame "
+                << source_occupancy(w, slot) << ", mean confidence "
+                << source_mean_confidence(w, slot) << "\n";
+    }
+    for (size_t c = 0; c < classes_; c++) {
+      uint64_t n = detections(w, c);
+      if (n == 0)
+        continue;
+      tag();
+      if (c == classes_ - 1) {
+        std::cerr << "   class other: ";
+      } else {
+        std::cerr << "   class " << c << ": ";
+      }
+      std::cerr << n << " detections, " << occupancy(w, c)
+                << "/frame, mean confidence " << mean_confidence(w, c) << "\n";
+    }
+  }
+}
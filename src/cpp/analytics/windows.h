@@ -0,0 +1,130 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "analytics/aligned.h"
+#include "analytics/frame_columns.h"
+#include "analytics/report_tick.h"
+#include "analytics/source_index.h"
+#include "common/config.h"
+
+// ================= Sliding windows =================
+//
+// Per-class and per-source aggregates over the last N seconds, for several
+// N at once (`[windows] spans_sec`): detections, mean confidence and
+// occupancy (objects per frame).
+//
+// Time is cut into buckets of `bucket_sec`, closed by an event-loop timer
+// (see report_tick.h), and kept in a ring as long as the longest window.
+// A frame only adds to the current bucket. Closing a bucket adds it to each
+// window's running sums and subtracts the bucket that just left that
+// window, so both are O(1) in the history length; a window's value is its
+// running sums plus the current bucket. Confidence is summed in fixed point
+// (1e-6), so adding and subtracting buckets never drifts.
+class SlidingWindows {
+public:
+  explicit SlidingWindows(const Config &cfg);
+
+  // Off when `[windows] spans_sec` is empty.
+  bool enabled() const { return !spans_.empty(); }
+
+  // ---------- hot path ----------
+
+  // Closes the buckets whose report tick passed since the last payload.
+  void begin_message() {
+    if (uint32_t closed = tick_.elapsed())
+      advance(closed);
+  }
+
+  // Adds `frame`, from source slot `slot`, to the current bucket.
+  void add_frame(size_t slot, const FrameColumns &frame) {
+    uint64_t *row = bucket(head_);
+    uint64_t *det = row + kClassDetections * classes_;
+    uint64_t *conf = row + kClassConfidence * classes_;
+    const int32_t *cls = frame.class_id();
+    const float *score = frame.confidence();
+    size_t n = frame.size();
+    uint64_t conf_total = 0;
+    for (size_t i = 0; i < n; i++) {
+      auto c = static_cast<size_t>(cls[i]);
+      size_t b = cls[i] >= 0 && c < classes_ - 1 ? c : classes_ - 1;
+      // Clamped to [0, 1] first: the decoders pass any float, and NaN
+      // fails the comparison.
+      float clamped = score[i] >= 0.0f ? std::min(score[i], 1.0f) : 0.0f;
+      auto micros = static_cast<uint64_t>(clamped * 1e6f + 0.5f);
+      det[b]++;
+      conf[b] += micros;
+      conf_total += micros;
+    }
+    uint64_t *src = row + kClassColumns * classes_;
+    src[kSourceFrames * sources_ + slot]++;
+    src[kSourceDetections * sources_ + slot] += n;
+    src[kSourceConfidence * sources_ + slot] += conf_total;
+  }
+
+  // Closes the current bucket `buckets` times (empty ones after the first).
+  void advance(uint32_t buckets);
+
+  // ---------- queries ----------
+
+  size_t size() const { return spans_.size(); }
+  int span_sec(size_t window) const {
+    return static_cast<int>(spans_[window]) * bucket_sec_;
+  }
+
+  // `cls` in [0, num_classes], num_classes being the "other" bucket.
+  uint64_t detections(size_t window, size_t cls) const;
+  double mean_confidence(size_t window, size_t cls) const;
+  // Detections of `cls` per frame, over all sources.
+  double occupancy(size_t window, size_t cls) const;
+
+  uint64_t source_frames(size_t window, size_t slot) const;
+  double source_occupancy(size_t window, size_t slot) const;
+  double source_mean_confidence(size_t window, size_t slot) const;
+
+  // ---------- cold path ----------
+
+  // Prints every window's per-source and per-class aggregates.
+  void print_interval(int worker, const SourceIndex &sources) const;
+
+private:
+  // Row layout: class columns (classes_ each), then source columns
+  // (sources_ each).
+  enum ClassColumn { kClassDetections, kClassConfidence, kClassColumns };
+  enum SourceColumn {
+    kSourceFrames,
+    kSourceDetections,
+    kSourceConfidence,
+    kSourceColumns
+  };
+
+  uint64_t *bucket(size_t i) { return buckets_.get() + i * row_; }
+  const uint64_t *bucket(size_t i) const { return buckets_.get() + i * row_; }
+
+  // Running sum of `column` over `window`, current bucket included.
+  uint64_t value(size_t window, size_t column) const {
+    return running_[window * row_ + column] + bucket(head_)[column];
+  }
+  size_t class_column(ClassColumn col, size_t cls) const {
+    return col * classes_ + cls;
+  }
+  size_t source_column(SourceColumn col, size_t slot) const {
+    return kClassColumns * classes_ + col * sources_ + slot;
+  }
+  uint64_t all_frames(size_t window) const;
+
+  int bucket_sec_;
+  size_t classes_; // num_classes + 1 ("other")
+  size_t sources_;
+  size_t row_;
+  std::vector<size_t> spans_; // window lengths in buckets
+  size_t ring_;               // buckets kept: the longest span
+  size_t head_ = 0;           // current bucket
+  uint64_t closed_ = 0;       // buckets closed so far
+  WindowTick tick_;
+
+  AlignedArray<uint64_t> buckets_; // ring_ x row_
+  AlignedArray<uint64_t> running_; // windows x row_, closed buckets only
+};
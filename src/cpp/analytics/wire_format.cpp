@@ -0,0 +1,129 @@
+#include "analytics/wire_format.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+inline const char *skip_ws(const char *p, const char *end) {
+  while (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+    ++p;
+  return p;
+}
+
+// Copies the detections `filter` keeps, up to the arena's limit, into an
+// arena frame. Branch-free compaction: every detection is copied, the
+// output only advances on a keep.
+const Detection *filter_detections(const char *detections, size_t total,
+                                   const DetectionFilter &filter,
+                                   FrameArena &arena, size_t &count) {
+  size_t limit = arena.max_detections();
+  Frame &frame = arena.acquire();
+  frame.detections.resize(std::min(total, limit));
+  Detection *out = frame.detections.data();
+
+  size_t n = 0;
+  size_t i = 0;
+  for (; i < total && n < limit; ++i) {
+    Detection det;
+    std::memcpy(&det, detections + i * sizeof(Detection), sizeof(det));
+    out[n] = det;
+    n += filter.keep(det.class_id, det.confidence);
+  }
+
+  // Past the limit, kept detections count as truncated.
+  size_t over = 0;
+  for (size_t j = i; j < total; ++j) {
+    Detection det;
+    std::memcpy(&det, detections + j * sizeof(Detection), sizeof(det));
+    over += filter.keep(det.class_id, det.confidence);
+  }
+  arena.note_truncated(over);
+  arena.note_filtered(total - n - over);
+
+  frame.detections.resize(n);
+  count = n;
+  return out;
+}
+
+} // namespace
+
+bool decode_binary_frame(const char *data, size_t size, FrameArena &arena,
+                         const DetectionFilter *filter) {
+  if (size < sizeof(WireHeader))
+    return false;
+
+  WireHeader header;
+  std::memcpy(&header, data, sizeof(header));
+
+  if (header.magic != kWireMagic || header.version != kWireVersion ||
+      header.header_size < sizeof(WireHeader) || header.header_size > size) {
+    return false;
+  }
+
+  size_t uri_offset = header.header_size;
+  if (header.uri_len > size - uri_offset)
+    return false;
+
+  size_t det_offset = (uri_offset + header.uri_len + 3) & ~size_t{3};
+  if (det_offset > size ||
+      (size - det_offset) / sizeof(Detection) < header.detection_count) {
+    return false;
+  }
+
+  FrameView view;
+  view.source_id = header.source_id;
+  view.frame_num = header.frame_num;
+  view.uri = std::string_view(data + uri_offset, header.uri_len);
+
+  const char *detections = data + det_offset;
+  if (filter != nullptr) {
+    view.detections = filter_detections(detections, header.detection_count,
+                                        *filter, arena, view.count);
+    return arena.add_view(view);
+  }
+
+  size_t count = header.detection_count;
+  if (count > arena.max_detections()) {
+    arena.note_truncated(count - arena.max_detections());
+    count = arena.max_detections();
+  }
+  view.count = count;
+
+  if (reinterpret_cast<uintptr_t>(detections) % alignof(Detection) == 0) {
+    view.detections = reinterpret_cast<const Detection *>(detections);
+  } else {
+    // libzmq may hand out messages at arbitrary offsets of its receive
+    // buffer; fall back to one memcpy rather than misaligned loads.
+    Frame &frame = arena.acquire();
+    frame.detections.resize(count);
+    std::memcpy(frame.detections.data(), detections, count * sizeof(Detection));
+    view.detections = frame.detections.data();
+  }
+
+  return arena.add_view(view);
+}
+
+bool peek_source_id(WireFormat format, const char *data, size_t size,
+                    int32_t &source_id) {
+  if (format == WireFormat::kBinary) {
+    if (size < sizeof(WireHeader))
+      return false;
+    std::memcpy(&source_id, data + offsetof(WireHeader, source_id),
+                sizeof(source_id));
+    return true;
+  }
+
+  // `{ "123": [...`
+  const char *end = data + size;
+  const char *p = skip_ws(data, end);
+  if (p == end || *p != '{')
+    return false;
+  p = skip_ws(p + 1, end);
+  if (p == end || *p != '"')
+    return false;
+  ++p;
+  auto [key_end, ec] = std::from_chars(p, end, source_id);
+  return ec == std::errc() && key_end != end && *key_end == '"';
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "analytics/detection_filter.h"
+#include "analytics/frame.h"
+#include "analytics/frame_arena.h"
+#include "common/config.h"
+
+// ================= Binary wire format (v1) =================
+//
+// Little-endian, fixed layout, one source per message:
+//
+//   WireHeader                      24 bytes
+//   uri bytes                       uri_len, zero-padded to 4 bytes
+//   Detection[detection_count]      28 bytes each, same layout as `Detection`
+//
+// The producer side lives in src/python/yolo/inference/metadata.py
+// (`encode_binary_frame`); keep the two in sync.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "binary wire format assumes a little-endian host"
+#endif
+
+constexpr uint32_t kWireMagic = 0x54454459; // "YDET"
+constexpr uint16_t kWireVersion = 1;
+
+struct WireHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size; // bytes before the uri; lets v1 readers skip new fields
+  int32_t source_id;
+  int32_t frame_num;
+  uint32_t detection_count;
+  uint32_t uri_len;
+};
+
+static_assert(sizeof(WireHeader) == 24, "WireHeader layout changed");
+static_assert(std::is_standard_layout<Detection>::value &&
+                  std::is_trivially_copyable<Detection>::value,
+              "Detection must stay POD to be read in place");
+static_assert(sizeof(Detection) == 28, "Detection layout changed");
+
+// Validates a binary frame and adds a FrameView to `arena` that points
+// straight into `data` (no copy, no parse). `data` must outlive the view.
+// Only if the detection array is misaligned, or a `filter` is given, are
+// detections copied into an arena frame (then only the ones it keeps).
+// Returns false on a malformed or unsupported message.
+bool decode_binary_frame(const char *data, size_t size, FrameArena &arena,
+                         const DetectionFilter *filter = nullptr);
+
+// Reads the source id of a payload in either format without decoding it: the
+// header field for binary frames, the first object key for JSON.
+bool peek_source_id(WireFormat format, const char *data, size_t size,
+                    int32_t &source_id);
@@ -0,0 +1,144 @@
+#include "analytics/worker_pool.h"
+
+#include <cmath>
+#include <iostream>
+
+#include "analytics/affinity.h"
+#include "analytics/hyperloglog.h"
+#include "analytics/spin_wait.h"
+
+WorkerPool::WorkerPool(const Config &cfg, size_t workers, Publisher *publisher)
+    : format_(cfg.zmq.format), spin_iterations_(cfg.pipeline.spin_iterations),
+      busy_poll_(cfg.affinity.busy_poll), publisher_(publisher) {
+  if (workers == 0)
+    workers = 1;
+
+  const auto &cpus = cfg.affinity.worker_cpus;
+  workers_.resize(workers);
+  threads_.reserve(workers);
+  std::vector<std::future<void>> started;
+  started.reserve(workers);
+  for (size_t i = 0; i < workers; i++) {
+    int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+    std::cout << "  worker " << i << ": " << describe_cpu(cpu) << "\n";
+    std::promise<void> ready;
+    started.push_back(ready.get_future());
+    threads_.emplace_back(
+        [this, &cfg, i, cpu, ready = std::move(ready)]() mutable {
+          start(cfg, i, cpu, ready);
+        });
+  }
+
+  // `cfg` must outlive construction, and `dispatch` needs every worker. A
+  // worker that failed to start fails the pool, once the others are joined.
+  try {
+    for (auto &future : started)
+      future.get();
+  } catch (...) {
+    stop();
+    throw;
+  }
+}
+
+void WorkerPool::start(const Config &cfg, size_t index, int cpu,
+                       std::promise<void> &ready) {
+  Worker *self = nullptr;
+  try {
+    pin_current_thread(cpu);
+
+    auto ring_capacity = static_cast<size_t>(cfg.pipeline.ring_capacity);
+    size_t batch_capacity =
+        cfg.overload.policy == OverloadPolicy::kQueue ? 1 : ring_capacity;
+    auto worker = std::make_unique<Worker>(cfg, ring_capacity, batch_capacity);
+    worker->consumer.set_worker(static_cast<int>(index));
+    if (publisher_ != nullptr)
+      worker->consumer.set_publish_queue(&publisher_->queue(index));
+
+    self = worker.get();
+    workers_[index] = std::move(worker);
+  } catch (...) {
+    ready.set_exception(std::current_exception());
+    return;
+  }
+  ready.set_value();
+
+  run(*self);
+}
+
+WorkerPool::~WorkerPool() { stop(); }
+
+void WorkerPool::dispatch(zmq::message_t &payload) {
+  int32_t source_id = 0;
+  // Unroutable payloads go to worker 0, whose decoder rejects them.
+  size_t shard = peek_source_id(format_,
+                                static_cast<const char *>(payload.data()),
+                                payload.size(), source_id)
+                     ? shard_of(source_id, workers_.size())
+                     : 0;
+
+  auto &ring = workers_[shard]->ring;
+  if (ring.try_push(payload))
+    return;
+
+  ring_full_++;
+  SpinWait spin(spin_iterations_, busy_poll_);
+  while (!ring.try_push(payload))
+    spin.wait();
+}
+
+void WorkerPool::stop() {
+  stopping_.store(true, std::memory_order_release);
+  for (auto &thread : threads_) {
+    if (thread.joinable())
+      thread.join();
+  }
+}
+
+void WorkerPool::print_final_summaries() const {
+  for (const auto &worker : workers_) {
+    worker->consumer.print_final_summary();
+  }
+  if (workers_.size() < 2)
+    return;
+  const UniqueTracks *first = workers_.front()->consumer.uniques();
+  if (first == nullptr)
+    return;
+  // Workers own disjoint sources; their sketches merge into the total.
+  HyperLogLog all(first->precision());
+  for (const auto &worker : workers_) {
+    worker->consumer.uniques()->merge_into(all);
+  }
+  std::cerr << "[UNIQUE] all workers: ~" << std::llround(all.estimate())
+            << " unique tracks\n";
+}
+
+uint64_t WorkerPool::shed() const {
+  uint64_t total = 0;
+  for (const auto &worker : workers_) {
+    total += worker->consumer.shedder().shed();
+  }
+  return total;
+}
+
+void WorkerPool::run(Worker &worker) {
+  zmq::message_t *batch = worker.batch.data();
+  size_t capacity = worker.batch.size();
+  SpinWait spin(spin_iterations_, busy_poll_);
+
+  while (true) {
+    size_t n = 0;
+    while (n < capacity && worker.ring.try_pop(batch[n]))
+      n++;
+    if (n == 0) {
+      if (stopping_.load(std::memory_order_acquire) && worker.ring.size() == 0)
+        break;
+      spin.wait();
+      continue;
+    }
+    spin.reset();
+
+    worker.consumer.metrics().on_ring(worker.ring.size() + n);
+    worker.consumer.consume_batch(batch, n);
+    worker.consumer.maybe_report();
+  }
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "analytics/consumer.h"
+#include "analytics/publisher.h"
+#include "analytics/spsc_ring.h"
+#include "analytics/wire_format.h"
+#include "common/config.h"
+#include <zmq.hpp>
+
+// Payloads carrying several sources are routed by their first one (the
+// producer sends one per message). Every frame of a source lands on the same
+// worker, so per-source ordering is preserved and per-source state never
+// leaves its worker thread.
+inline size_t shard_of(int32_t source_id, size_t workers) {
+  return static_cast<size_t>(static_cast<uint32_t>(source_id)) % workers;
+}
+
+// N decode/analytics threads, each owning a Consumer and fed by its own SPSC
+// ring. `dispatch` is called from a single receive thread.
+//
+// Each thread pins itself (`[affinity] worker_cpus`) and only then builds its
+// ring and Consumer, so their pages are first touched on its NUMA node.
+// With a `publisher`, worker i publishes through its queue i. The
+// constructor rethrows what a worker threw while building its state.
+class WorkerPool {
+public:
+  WorkerPool(const Config &cfg, size_t workers,
+             Publisher *publisher = nullptr);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  size_t size() const { return workers_.size(); }
+
+  // Moves `payload` into the owning worker's ring, spinning while it is
+  // full. `payload` is left holding a recycled message buffer.
+  void dispatch(zmq::message_t &payload);
+
+  // Lets every worker drain its ring, then joins them.
+  void stop();
+
+  // Times the receive thread found a worker's ring full.
+  uint64_t ring_full() const { return ring_full_; }
+
+  // Frames shed by the overload policy across workers; call after `stop`.
+  uint64_t shed() const;
+
+  // Each worker's final analytics summary; call after `stop`.
+  void print_final_summaries() const;
+
+private:
+  struct Worker {
+    Worker(const Config &cfg, size_t ring_capacity, size_t batch_capacity)
+        : ring(ring_capacity), consumer(cfg), batch(batch_capacity) {}
+
+    SpscRing<zmq::message_t> ring;
+    Consumer consumer;
+    // What one wake-up drains from the ring; the overload policy sheds
+    // within it. Holds a single slot under the `queue` policy.
+    std::vector<zmq::message_t> batch;
+  };
+
+  // Thread body: pin, build worker `index`, then drain its ring. `ready`
+  // gets whatever the build throws.
+  void start(const Config &cfg, size_t index, int cpu,
+             std::promise<void> &ready);
+  void run(Worker &worker);
+
+  WireFormat format_;
+  int spin_iterations_;
+  bool busy_poll_; // workers yield instead of sleeping on an empty ring
+  Publisher *publisher_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> stopping_{false};
+  uint64_t ring_full_ = 0; // receive thread only
+};
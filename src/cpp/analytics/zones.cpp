@@ -0,0 +1,259 @@
+#include "analytics/zones.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Crossing-number test of points [0, n) against one polygon; sets bit i of
+// `out` (zeroed by the caller) for each point inside. Edge arrays start at
+// the zone's first edge. Reads the coordinate columns up to n rounded up to
+// the vector width; FrameColumns pads them to whole cache lines.
+struct Polygon {
+  const float *y0;
+  const float *y1;
+  const float *x0;
+  const float *k;
+  size_t edges;
+  float min_x, min_y, max_x, max_y;
+};
+
+#if defined(__AVX2__)
+
+void test_points(const float *px, const float *py, size_t n,
+                 const Polygon &poly, uint64_t *out) {
+  const __m256 min_x = _mm256_set1_ps(poly.min_x);
+  const __m256 min_y = _mm256_set1_ps(poly.min_y);
+  const __m256 max_x = _mm256_set1_ps(poly.max_x);
+  const __m256 max_y = _mm256_set1_ps(poly.max_y);
+
+  for (size_t i = 0; i < n; i += 8) {
+    __m256 x = _mm256_load_ps(px + i);
+    __m256 y = _mm256_load_ps(py + i);
+    __m256 in_box = _mm256_and_ps(
+        _mm256_and_ps(_mm256_cmp_ps(x, min_x, _CMP_GE_OQ),
+                      _mm256_cmp_ps(x, max_x, _CMP_LE_OQ)),
+        _mm256_and_ps(_mm256_cmp_ps(y, min_y, _CMP_GE_OQ),
+                      _mm256_cmp_ps(y, max_y, _CMP_LE_OQ)));
+    if (_mm256_movemask_ps(in_box) == 0)
+      continue;
+
+    __m256 inside = _mm256_setzero_ps();
+    for (size_t e = 0; e < poly.edges; e++) {
+      __m256 y0 = _mm256_set1_ps(poly.y0[e]);
+      __m256 spans = _mm256_and_ps(
+          _mm256_cmp_ps(y, y0, _CMP_GE_OQ),
+          _mm256_cmp_ps(y, _mm256_set1_ps(poly.y1[e]), _CMP_LT_OQ));
+      __m256 xi = _mm256_add_ps(
+          _mm256_set1_ps(poly.x0[e]),
+          _mm256_mul_ps(_mm256_sub_ps(y, y0), _mm256_set1_ps(poly.k[e])));
+      inside = _mm256_xor_ps(
+          inside, _mm256_and_ps(spans, _mm256_cmp_ps(x, xi, _CMP_LT_OQ)));
+    }
+    auto mask = static_cast<uint64_t>(
+        _mm256_movemask_ps(_mm256_and_ps(inside, in_box)));
+    out[i / 64] |= mask << (i % 64);
+  }
+}
+
+#elif defined(__SSE2__)
+
+void test_points(const float *px, const float *py, size_t n,
+                 const Polygon &poly, uint64_t *out) {
+  const __m128 min_x = _mm_set1_ps(poly.min_x);
+  const __m128 min_y = _mm_set1_ps(poly.min_y);
+  const __m128 max_x = _mm_set1_ps(poly.max_x);
+  const __m128 max_y = _mm_set1_ps(poly.max_y);
+
+  for (size_t i = 0; i < n; i += 4) {
+    __m128 x = _mm_load_ps(px + i);
+    __m128 y = _mm_load_ps(py + i);
+    __m128 in_box =
+        _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(x, min_x), _mm_cmple_ps(x, max_x)),
+                   _mm_and_ps(_mm_cmpge_ps(y, min_y), _mm_cmple_ps(y, max_y)));
+    if (_mm_movemask_ps(in_box) == 0)
+      continue;
+
+    __m128 inside = _mm_setzero_ps();
+    for (size_t e = 0; e < poly.edges; e++) {
+      __m128 y0 = _mm_set1_ps(poly.y0[e]);
+      __m128 spans = _mm_and_ps(_mm_cmpge_ps(y, y0),
+                                _mm_cmplt_ps(y, _mm_set1_ps(poly.y1[e])));
+      __m128 xi =
+          _mm_add_ps(_mm_set1_ps(poly.x0[e]),
+                     _mm_mul_ps(_mm_sub_ps(y, y0), _mm_set1_ps(poly.k[e])));
+      inside = _mm_xor_ps(inside, _mm_and_ps(spans, _mm_cmplt_ps(x, xi)));
+    }
+    auto mask =
+        static_cast<uint64_t>(_mm_movemask_ps(_mm_and_ps(inside, in_box)));
+    out[i / 64] |= mask << (i % 64);
+  }
+}
+
+#else
+
+void test_points(const float *px, const float *py, size_t n,
+                 const Polygon &poly, uint64_t *out) {
+  for (size_t i = 0; i < n; i++) {
+    float x = px[i];
+    float y = py[i];
+    if (x < poly.min_x || x > poly.max_x || y < poly.min_y || y > poly.max_y)
+      continue;
+    bool inside = false;
+    for (size_t e = 0; e < poly.edges; e++) {
+      if (y >= poly.y0[e] && y < poly.y1[e] &&
+          x < poly.x0[e] + (y - poly.y0[e]) * poly.k[e]) {
+        inside = !inside;
+      }
+    }
+    if (inside)
+      out[i / 64] |= uint64_t{1} << (i % 64);
+  }
+}
+
+#endif
+
+} // namespace
+
+ZoneSet::ZoneSet(const Config &cfg, int32_t source_id)
+    : num_classes_(static_cast<size_t>(cfg.analytics.num_classes)),
+      row_(num_classes_ + 1),
+      words_((static_cast<size_t>(std::max(1, cfg.analytics.max_detections)) +
+              63) /
+             64) {
+  for (const auto &zc : cfg.zones) {
+    if (zc.source_id != source_id)
+      continue;
+    if (zones_.size() == kMaxZones) {
+      std::cerr << "[ZONE] source " << source_id << ": more than "
+                << kMaxZones << " zones, ignoring " << zc.name << "\n";
+      continue;
+    }
+
+    Zone zone{};
+    zone.name = zc.name;
+    zone.first_edge = edge_y0_.size();
+    zone.min_x = zone.max_x = zc.points[0].first;
+    zone.min_y = zone.max_y = zc.points[0].second;
+    for (size_t p = 0; p < zc.points.size(); p++) {
+      auto [ax, ay] = zc.points[p];
+      auto [bx, by] = zc.points[(p + 1) % zc.points.size()];
+      zone.min_x = std::min(zone.min_x, ax);
+      zone.max_x = std::max(zone.max_x, ax);
+      zone.min_y = std::min(zone.min_y, ay);
+      zone.max_y = std::max(zone.max_y, ay);
+      if (ay == by)
+        continue; // horizontal: never spans a scanline
+      if (ay > by) {
+        std::swap(ax, bx);
+        std::swap(ay, by);
+      }
+      edge_y0_.push_back(ay);
+      edge_y1_.push_back(by);
+      edge_x0_.push_back(ax);
+      edge_k_.push_back((bx - ax) / (by - ay));
+    }
+    zone.edges = edge_y0_.size() - zone.first_edge;
+
+    zone.loiter_frames = zc.loiter_frames;
+    zone.all_classes = zc.classes.empty();
+    for (int c : zc.classes) {
+      if (c < 256)
+        zone.class_mask[c / 64] |= uint64_t{1} << (c % 64);
+    }
+    zones_.push_back(std::move(zone));
+  }
+
+  class_zones_.assign(257, 0);
+  for (size_t z = 0; z < zones_.size(); z++) {
+    for (size_t c = 0; c < class_zones_.size(); c++) {
+      if (counts(zones_[z], c < 256 ? static_cast<int32_t>(c) : -1))
+        class_zones_[c] |= uint64_t{1} << z;
+    }
+  }
+
+  size_t zones = std::max<size_t>(zones_.size(), 1);
+  inside_ = make_aligned_array<uint64_t>(zones * words_);
+  total_ = make_aligned_array<uint32_t>(zones);
+  by_class_ = make_aligned_array<uint32_t>(zones * row_);
+  sum_.assign(zones, 0);
+  peak_.assign(zones, 0);
+}
+
+void ZoneSet::evaluate(const FrameColumns &frame) {
+  size_t n = frame.size();
+  size_t used_words = (n + 63) / 64;
+  const int32_t *cls = frame.class_id();
+
+  for (size_t z = 0; z < zones_.size(); z++) {
+    const Zone &zone = zones_[z];
+    uint64_t *bits = inside_.get() + z * words_;
+    std::memset(bits, 0, used_words * sizeof(uint64_t));
+
+    Polygon poly{edge_y0_.data() + zone.first_edge,
+                 edge_y1_.data() + zone.first_edge,
+                 edge_x0_.data() + zone.first_edge,
+                 edge_k_.data() + zone.first_edge,
+                 zone.edges,
+                 zone.min_x,
+                 zone.min_y,
+                 zone.max_x,
+                 zone.max_y};
+    test_points(frame.anchor_x(), frame.anchor_y(), n, poly, bits);
+    // Vector lanes past `n` read padding; drop them.
+    if (n % 64 != 0)
+      bits[used_words - 1] &= (uint64_t{1} << (n % 64)) - 1;
+
+    // Recount, clearing only a row that was used last frame.
+    uint32_t *row = by_class_.get() + z * row_;
+    if (total_[z] != 0)
+      std::memset(row, 0, row_ * sizeof(uint32_t));
+    uint32_t total = 0;
+    for (size_t w = 0; w < used_words; w++) {
+      for (uint64_t b = bits[w]; b != 0; b &= b - 1) {
+        size_t i = w * 64 + static_cast<size_t>(__builtin_ctzll(b));
+        int32_t c = cls[i];
+        if (!counts(zone, c))
+          continue;
+        auto bucket = static_cast<size_t>(c);
+        row[c >= 0 && bucket < num_classes_ ? bucket : num_classes_]++;
+        total++;
+      }
+    }
+    total_[z] = total;
+    sum_[z] += total;
+    peak_[z] = std::max(peak_[z], total);
+  }
+  frames_++;
+}
+
+void ZoneSet::print_interval(int worker, int32_t source_id) {
+  for (size_t z = 0; z < zones_.size(); z++) {
+    std::cerr << "[ZONE]";
+    if (worker >= 0)
+      std::cerr << " w" << worker;
+    std::cerr << " source " << source_id << " " << zones_[z].name << ": now "
+              << total_[z] << ", avg "
+              << (frames_ > 0 ? static_cast<double>(sum_[z]) / frames_ : 0.0)
+              << ", peak " << peak_[z];
+    const uint32_t *row = by_class_.get() + z * row_;
+    for (size_t c = 0; c < row_; c++) {
+      if (row[c] == 0)
+        continue;
+      if (c == num_classes_) {
+        std::cerr << " other:" << row[c];
+      } else {
+        std::cerr << " " << c << ":" << row[c];
+      }
+    }
+    std::cerr << "\n";
+    sum_[z] = 0;
+    peak_[z] = 0;
+  }
+  frames_ = 0;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "analytics/aligned.h"
+#include "analytics/frame_columns.h"
+#include "common/config.h"
+
+// ================= ROI zones =================
+//
+// Polygon regions of interest on one source (`[[zones]]` in config.toml) and
+// their per-frame occupancy by class.
+//
+// Everything a test needs is precomputed at startup: per edge the lower and
+// upper y, the x at the lower end and dx/dy (horizontal edges dropped, they
+// never cross a scanline); per zone a bounding box and a class mask. A frame
+// is then tested zone by zone over the SoA anchor columns, 8 points per step
+// with AVX2, 4 with SSE2, or one at a time otherwise (crossing-number rule).
+// Results are per-zone bitsets over detections, so counting only visits
+// detections that are inside.
+
+class ZoneSet {
+public:
+  // Most zones one source may have; zone membership fits in a uint64_t.
+  static constexpr size_t kMaxZones = 64;
+
+  // Zones of `source_id` from `cfg.zones`.
+  ZoneSet(const Config &cfg, int32_t source_id);
+
+  // No zones.
+  ZoneSet() = default;
+
+  size_t size() const { return zones_.size(); }
+  const std::string &name(size_t zone) const { return zones_[zone].name; }
+
+  // ---------- hot path ----------
+
+  // Tests every anchor of `frame` against every zone and recounts
+  // occupancy.
+  void evaluate(const FrameColumns &frame);
+
+  // Zones containing detection `i` of the last evaluated frame, as bits.
+  uint64_t zones_of(size_t i) const {
+    uint64_t bits = 0;
+    for (size_t z = 0; z < zones_.size(); z++) {
+      bits |= ((inside_[z * words_ + i / 64] >> (i % 64)) & 1) << z;
+    }
+    return bits;
+  }
+
+  // Bitset over the last evaluated frame's detections inside `zone`.
+  const uint64_t *inside_bits(size_t zone) const {
+    return inside_.get() + zone * words_;
+  }
+
+  // Zones that count class `cls`, as bits.
+  uint64_t zones_counting(int32_t cls) const {
+    auto c = static_cast<uint32_t>(cls);
+    return class_zones_[c < 256 ? c : 256];
+  }
+
+  // Frames a track may stay in `zone` before a loitering alert; 0 = never.
+  int32_t loiter_frames(size_t zone) const {
+    return zones_[zone].loiter_frames;
+  }
+
+  // Occupancy of the last evaluated frame.
+  uint32_t occupancy(size_t zone) const { return total_[zone]; }
+  // `cls` in [0, num_classes]; num_classes is the "other" bucket.
+  uint32_t occupancy(size_t zone, size_t cls) const {
+    return by_class_[zone * row_ + cls];
+  }
+
+  // ---------- cold path ----------
+
+  // Prints current / average / peak occupancy since the last call.
+  void print_interval(int worker, int32_t source_id);
+
+private:
+  struct Zone {
+    std::string name;
+    size_t first_edge;
+    size_t edges;
+    float min_x, min_y, max_x, max_y;
+    uint64_t class_mask[4]; // classes counted, bit per id < 256
+    bool all_classes;
+    int32_t loiter_frames;
+  };
+
+  bool counts(const Zone &zone, int32_t cls) const {
+    if (zone.all_classes)
+      return true;
+    auto c = static_cast<uint32_t>(cls);
+    return c < 256 && ((zone.class_mask[c / 64] >> (c % 64)) & 1);
+  }
+
+  std::vector<Zone> zones_;
+  std::vector<uint64_t> class_zones_; // class id (256 = other ids) -> zones
+
+  // Edges of all zones, SoA.
+  std::vector<float> edge_y0_; // lower y
+  std::vector<float> edge_y1_; // upper y
+  std::vector<float> edge_x0_; // x at y0
+  std::vector<float> edge_k_;  // dx / dy
+
+  size_t num_classes_ = 0;
+  size_t row_ = 0;   // num_classes + 1
+  size_t words_ = 0; // uint64 words per zone bitset
+
+  AlignedArray<uint64_t> inside_; // zones x words
+  AlignedArray<uint32_t> total_;
+  AlignedArray<uint32_t> by_class_; // zones x row
+
+  // Interval stats.
+  std::vector<uint64_t> sum_;
+  std::vector<uint32_t> peak_;
+  uint64_t frames_ = 0;
+};
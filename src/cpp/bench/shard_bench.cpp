@@ -0,0 +1,133 @@
+// Sharded worker pool throughput: frames/s and frames/s per worker as the
+// worker count grows, with synthetic payloads shaped like the Python
+// producer's (same fields, same JSON layout).
+//
+//   ./build/shard_bench [detections=300] [sources=64] [frames_per_source=500]
+//                       [max_workers=hardware threads - 1] [json|binary]
+//
+// The calling thread plays the receive thread: it copies each payload into a
+// zmq::message_t (as libzmq would on recv) and dispatches it.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analytics/wire_format.h"
+#include "analytics/worker_pool.h"
+#include "common/config.h"
+
+namespace {
+
+std::string make_json(int source_id, int frame_num, int detections) {
+  std::string s = "{\"" + std::to_string(source_id) + "\": [";
+  for (int i = 0; i < detections; i++) {
+    if (i > 0)
+      s += ", ";
+    s += "{\"uri\": \"rtsp://camera/stream\", \"class_id\": " +
+         std::to_string(i % 3) + ", \"track_id\": " + std::to_string(100 + i) +
+         ", \"confidence\": 0.9" + std::to_string(i % 9) +
+         ", \"bbox\": {\"left\": " + std::to_string((i * 37) % 640) +
+         ", \"top\": " + std::to_string((i * 53) % 480) +
+         ", \"width\": 50, \"height\": 100, \"border_width\": 0, "
+         "\"has_bg_color\": 0}, \"frame_num\": " +
+         std::to_string(frame_num) + "}";
+  }
+  return s + "]}";
+}
+
+std::string make_binary(int source_id, int frame_num, int detections) {
+  const char uri[] = "rtsp://camera/stream";
+  WireHeader header{kWireMagic,
+                    kWireVersion,
+                    sizeof(WireHeader),
+                    source_id,
+                    frame_num,
+                    static_cast<uint32_t>(detections),
+                    sizeof(uri) - 1};
+  std::string s(reinterpret_cast<const char *>(&header), sizeof(header));
+  s.append(uri, sizeof(uri) - 1);
+  s.resize((s.size() + 3) & ~size_t{3}, '\0');
+  for (int i = 0; i < detections; i++) {
+    Detection det{100 + i,
+                  i % 3,
+                  0.9f,
+                  {static_cast<float>((i * 37) % 640),
+                   static_cast<float>((i * 53) % 480), 50.0f, 100.0f}};
+    s.append(reinterpret_cast<const char *>(&det), sizeof(det));
+  }
+  return s;
+}
+
+int arg_or(int argc, char **argv, int index, int fallback) {
+  return argc > index ? std::atoi(argv[index]) : fallback;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int detections = arg_or(argc, argv, 1, 300);
+  int sources = arg_or(argc, argv, 2, 64);
+  int frames_per_source = arg_or(argc, argv, 3, 500);
+  int hw = static_cast<int>(std::thread::hardware_concurrency());
+  int max_workers = arg_or(argc, argv, 4, std::max(1, hw - 1));
+  bool binary = argc > 5 && std::strcmp(argv[5], "binary") == 0;
+
+  // The binary's defaults, so the numbers describe a runnable setup.
+  Config cfg = load_config("");
+  cfg.analytics.max_sources = sources;
+  cfg.analytics.max_detections = detections;
+  cfg.zmq.format = binary ? WireFormat::kBinary : WireFormat::kJson;
+  cfg.pipeline.mode = PipelineMode::kSharded;
+
+  // A few distinct frames per source so the decoder sees varying input.
+  constexpr int kVariants = 4;
+  std::vector<std::string> payloads;
+  for (int v = 0; v < kVariants; v++) {
+    for (int src = 0; src < sources; src++) {
+      payloads.push_back(binary ? make_binary(src, v, detections)
+                                : make_json(src, v, detections));
+    }
+  }
+
+  long total = static_cast<long>(sources) * frames_per_source;
+  std::printf("detections/frame=%d sources=%d frames=%ld format=%s\n",
+              detections, sources, total, binary ? "binary" : "json");
+  std::printf("%8s %14s %18s %11s\n", "workers", "frames/s", "frames/s/worker",
+              "efficiency");
+
+  double base_per_worker = 0.0;
+  for (int workers = 1; workers <= std::min(max_workers, sources);
+       workers *= 2) {
+    zmq::message_t msg;
+    double secs = 0.0;
+    {
+      // Timed from the first dispatch until the workers have drained;
+      // spawning, pinning and teardown are left out.
+      WorkerPool pool(cfg, static_cast<size_t>(workers));
+      auto start = std::chrono::steady_clock::now();
+      for (long i = 0; i < total; i++) {
+        const std::string &p = payloads[static_cast<size_t>(i) %
+                                        payloads.size()];
+        msg.rebuild(p.data(), p.size());
+        pool.dispatch(msg);
+      }
+      pool.stop();
+      secs = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           start)
+                 .count();
+    }
+
+    double fps = total / secs;
+    double per_worker = fps / workers;
+    if (workers == 1)
+      base_per_worker = per_worker;
+    std::printf("%8d %14.0f %18.0f %10.0f%%\n", workers, fps, per_worker,
+                100.0 * per_worker / base_per_worker);
+  }
+  return 0;
+}
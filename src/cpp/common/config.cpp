@@ -1,24 +1,457 @@
 #include "common/config.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <set>
 #include <string>
+#include <utility>
 
 #include <toml++/toml.hpp>
 
+namespace {
+
+// `[x, y]` -> (x, y); exits naming `what` if `node` is anything else.
+std::pair<float, float> read_point(const toml::node &node,
+                                   const std::string &what) {
+  const auto *xy = node.as_array();
+  auto x = xy && xy->size() == 2 ? (*xy)[0].value<double>() : std::nullopt;
+  auto y = xy && xy->size() == 2 ? (*xy)[1].value<double>() : std::nullopt;
+  if (!x || !y) {
+    std::cerr << what << ": points must be [x, y]\n";
+    std::exit(1);
+  }
+  return {static_cast<float>(*x), static_cast<float>(*y)};
+}
+
+// Optional `classes = [id, ...]` of `tbl`. Class sets are 256-bit masks.
+std::vector<int> read_classes(const toml::table &tbl, const std::string &what) {
+  std::vector<int> classes;
+  if (const auto *array = tbl["classes"].as_array()) {
+    for (const auto &c : *array) {
+      auto value = c.value<int>();
+      if (!value || *value < 0 || *value > 255) {
+        std::cerr << what << ": classes must be class ids below 256\n";
+        std::exit(1);
+      }
+      classes.push_back(*value);
+    }
+  }
+  return classes;
+}
+
+// `frames`, or `ms` converted at `fps` (rounded up); `fallback` if neither
+// is set.
+int frames_of(std::optional<int64_t> frames, std::optional<int64_t> ms,
+              int fps, int fallback, const std::string &what) {
+  int64_t value = fallback;
+  if (frames) {
+    value = *frames;
+  } else if (ms) {
+    value = (*ms * fps + 999) / 1000;
+  }
+  if (value < 0 || value > std::numeric_limits<int32_t>::max()) {
+    std::cerr << what << " must be >= 0\n";
+    std::exit(1);
+  }
+  return static_cast<int>(value);
+}
+
+} // namespace
+
 // cppcheck-suppress unusedFunction
 Config load_config(const std::string &path) {
   Config cfg;
 
   try {
-    auto tbl = toml::parse_file(path);
+    toml::table tbl = path.empty() ? toml::table{} : toml::parse_file(path);
 
     cfg.analytics.max_sources = tbl["stream"]["max_sources"].value_or(1);
     cfg.analytics.max_detections = tbl["stream"]["max_detections"].value_or(16);
+    cfg.analytics.report_interval_sec =
+        tbl["stream"]["fps_check_interval_sec"].value_or(5);
+    if (cfg.analytics.report_interval_sec < 1) {
+      std::cerr << "stream.fps_check_interval_sec must be >= 1\n";
+      std::exit(1);
+    }
+    cfg.analytics.track_ttl_frames =
+        tbl["tracks"]["ttl_frames"].value_or(250);
+    cfg.analytics.num_classes = tbl["stream"]["num_classes"].value_or(80);
+    if (cfg.analytics.num_classes < 1) {
+      std::cerr << "stream.num_classes must be >= 1\n";
+      std::exit(1);
+    }
+    cfg.analytics.fps = tbl["stream"]["fps"].value_or(25);
+    if (cfg.analytics.fps < 1) {
+      std::cerr << "stream.fps must be >= 1\n";
+      std::exit(1);
+    }
+    cfg.analytics.track_expire_frames = frames_of(
+        tbl["tracks"]["expire_frames"].value<int64_t>(),
+        tbl["tracks"]["expire_ms"].value<int64_t>(), cfg.analytics.fps,
+        2 * cfg.analytics.fps, "tracks.expire_frames / expire_ms");
+    cfg.analytics.hll_precision = tbl["uniques"]["precision"].value_or(12);
+    if (cfg.analytics.hll_precision < 4 || cfg.analytics.hll_precision > 16) {
+      std::cerr << "uniques.precision must be in [4, 16]\n";
+      std::exit(1);
+    }
+
+    if (const auto *filter = tbl["filter"].as_table())
+      cfg.filter.classes = read_classes(*filter, "filter");
+    cfg.filter.min_confidence = tbl["filter"]["min_confidence"].value_or(0.0f);
+    if (!(cfg.filter.min_confidence >= 0.0f &&
+          cfg.filter.min_confidence <= 1.0f)) {
+      std::cerr << "filter.min_confidence must be in [0, 1]\n";
+      std::exit(1);
+    }
+
+    cfg.motion.enabled = tbl["motion"]["enabled"].value_or(false);
+    cfg.motion.alpha = tbl["motion"]["alpha"].value_or(0.5f);
+    cfg.motion.beta = tbl["motion"]["beta"].value_or(0.1f);
+    // Outside these gains the filter oscillates or diverges.
+    if (!(cfg.motion.alpha > 0.0f && cfg.motion.alpha <= 1.0f &&
+          cfg.motion.beta >= 0.0f &&
+          cfg.motion.beta < 4.0f - 2.0f * cfg.motion.alpha)) {
+      std::cerr << "motion.alpha must be in (0, 1] and motion.beta in "
+                   "[0, 4 - 2 alpha)\n";
+      std::exit(1);
+    }
 
     cfg.zmq.endpoint = tbl["zmq"]["endpoint"].value_or("tcp://127.0.0.1:5555");
-    cfg.zmq.socket_type = tbl["zmq"]["socket_type"].value_or("sub");
+    const std::string &ep = cfg.zmq.endpoint;
+    // No inproc://: the producer is always another process.
+    if (ep.rfind("tcp://", 0) != 0 && ep.rfind("ipc://", 0) != 0) {
+      std::cerr << "Unsupported zmq.endpoint: " << ep << " (tcp://, ipc://)\n";
+      std::exit(1);
+    }
+
+    std::string socket_type = tbl["zmq"]["socket_type"].value_or("sub");
+    if (socket_type == "sub") {
+      cfg.zmq.socket_type = SocketType::kSub;
+    } else if (socket_type == "pull") {
+      cfg.zmq.socket_type = SocketType::kPull;
+    } else {
+      std::cerr << "Unknown zmq.socket_type: " << socket_type
+                << " (sub|pull)\n";
+      std::exit(1);
+    }
+    cfg.zmq.bind = tbl["zmq"]["bind"].value_or(false);
     cfg.zmq.subscribe = tbl["zmq"]["subscribe"].value_or("");
     cfg.zmq.rcvhwm = tbl["zmq"]["rcvhwm"].value_or(1000);
+
+    std::string format = tbl["zmq"]["format"].value_or("json");
+    if (format == "json") {
+      cfg.zmq.format = WireFormat::kJson;
+    } else if (format == "binary") {
+      cfg.zmq.format = WireFormat::kBinary;
+    } else {
+      std::cerr << "Unknown zmq.format: " << format << " (json|binary)\n";
+      std::exit(1);
+    }
+
+    cfg.zmq.batch_size = tbl["zmq"]["batch_size"].value_or(1);
+    cfg.zmq.batch_max_latency_us =
+        tbl["zmq"]["batch_max_latency_us"].value_or(200);
+    if (cfg.zmq.batch_size < 1) {
+      std::cerr << "zmq.batch_size must be >= 1\n";
+      std::exit(1);
+    }
+    if (cfg.zmq.batch_max_latency_us < 0) {
+      std::cerr << "zmq.batch_max_latency_us must be >= 0\n";
+      std::exit(1);
+    }
+
+    std::string mode = tbl["pipeline"]["mode"].value_or("inline");
+    if (mode == "inline") {
+      cfg.pipeline.mode = PipelineMode::kInline;
+    } else if (mode == "pipelined") {
+      cfg.pipeline.mode = PipelineMode::kPipelined;
+    } else if (mode == "sharded") {
+      cfg.pipeline.mode = PipelineMode::kSharded;
+    } else {
+      std::cerr << "Unknown pipeline.mode: " << mode
+                << " (inline|pipelined|sharded)\n";
+      std::exit(1);
+    }
+    cfg.pipeline.workers = tbl["pipeline"]["workers"].value_or(1);
+    cfg.pipeline.ring_capacity =
+        tbl["pipeline"]["ring_capacity"].value_or(1024);
+    cfg.pipeline.spin_iterations =
+        tbl["pipeline"]["spin_iterations"].value_or(1000);
+    if (cfg.pipeline.workers < 1 || cfg.pipeline.workers > 256) {
+      std::cerr << "pipeline.workers must be in [1, 256]\n";
+      std::exit(1);
+    }
+    if (cfg.pipeline.ring_capacity < 1 ||
+        cfg.pipeline.ring_capacity > (1 << 20)) {
+      std::cerr << "pipeline.ring_capacity must be in [1, 1048576]\n";
+      std::exit(1);
+    }
+    if (cfg.pipeline.spin_iterations < 0) {
+      std::cerr << "pipeline.spin_iterations must be >= 0\n";
+      std::exit(1);
+    }
+
+    std::string policy = tbl["overload"]["policy"].value_or("queue");
+    if (policy == "queue") {
+      cfg.overload.policy = OverloadPolicy::kQueue;
+    } else if (policy == "conflate-per-source") {
+      cfg.overload.policy = OverloadPolicy::kConflatePerSource;
+    } else if (policy == "drop-oldest") {
+      cfg.overload.policy = OverloadPolicy::kDropOldest;
+    } else {
+      std::cerr << "Unknown overload.policy: " << policy
+                << " (queue|conflate-per-source|drop-oldest)\n";
+      std::exit(1);
+    }
+    cfg.overload.max_pending = tbl["overload"]["max_pending"].value_or(4);
+
+    // Shedding acts on what is drained per wake-up; inline mode needs a
+    // receive batch to drain into.
+    if (cfg.overload.policy != OverloadPolicy::kQueue &&
+        cfg.pipeline.mode == PipelineMode::kInline && cfg.zmq.batch_size < 2) {
+      std::cerr << "overload.policy = " << policy
+                << " needs zmq.batch_size > 1 in inline mode; using 256\n";
+      cfg.zmq.batch_size = 256;
+    }
+
+    std::string capture = tbl["capture"]["mode"].value_or("off");
+    if (capture == "off") {
+      cfg.capture.mode = CaptureMode::kOff;
+    } else if (capture == "record") {
+      cfg.capture.mode = CaptureMode::kRecord;
+    } else if (capture == "replay") {
+      cfg.capture.mode = CaptureMode::kReplay;
+    } else {
+      std::cerr << "Unknown capture.mode: " << capture
+                << " (off|record|replay)\n";
+      std::exit(1);
+    }
+    cfg.capture.path = tbl["capture"]["path"].value_or("capture.ydc");
+    cfg.capture.max_mb = tbl["capture"]["max_mb"].value_or(1024);
+    if (cfg.capture.max_mb < 1) {
+      std::cerr << "capture.max_mb must be >= 1\n";
+      std::exit(1);
+    }
+    cfg.capture.speed = tbl["capture"]["speed"].value_or(0.0);
+    if (cfg.capture.speed < 0.0) {
+      std::cerr << "capture.speed must be >= 0 (0 = as fast as possible)\n";
+      std::exit(1);
+    }
+
+    cfg.windows.bucket_sec = tbl["windows"]["bucket_sec"].value_or(1);
+    if (cfg.windows.bucket_sec < 1) {
+      std::cerr << "windows.bucket_sec must be >= 1\n";
+      std::exit(1);
+    }
+    if (const auto *spans = tbl["windows"]["spans_sec"].as_array()) {
+      for (const auto &span : *spans) {
+        auto value = span.value<int>();
+        // A day of 1 s buckets bounds the ring.
+        if (!value || *value < 1 ||
+            *value / cfg.windows.bucket_sec > 86400) {
+          std::cerr << "windows.spans_sec must be seconds, at most 86400 "
+                       "buckets each\n";
+          std::exit(1);
+        }
+        cfg.windows.spans_sec.push_back(*value);
+      }
+    }
+
+    cfg.heatmap.cols = tbl["heatmap"]["cols"].value_or(0);
+    cfg.heatmap.rows = tbl["heatmap"]["rows"].value_or(0);
+    if (cfg.heatmap.cols < 0 || cfg.heatmap.cols > 4096 ||
+        cfg.heatmap.rows < 0 || cfg.heatmap.rows > 4096 ||
+        (cfg.heatmap.cols == 0) != (cfg.heatmap.rows == 0)) {
+      std::cerr << "heatmap.cols / rows must both be in [1, 4096] (or 0)\n";
+      std::exit(1);
+    }
+    cfg.heatmap.frame_width = tbl["heatmap"]["frame_width"].value_or(1920.0f);
+    cfg.heatmap.frame_height = tbl["heatmap"]["frame_height"].value_or(1080.0f);
+    if (!(cfg.heatmap.frame_width > 0.0f && cfg.heatmap.frame_height > 0.0f)) {
+      std::cerr << "heatmap.frame_width / frame_height must be > 0\n";
+      std::exit(1);
+    }
+    std::string heatmap_mode = tbl["heatmap"]["mode"].value_or("anchor");
+    if (heatmap_mode == "anchor") {
+      cfg.heatmap.mode = HeatmapMode::kAnchor;
+    } else if (heatmap_mode == "center") {
+      cfg.heatmap.mode = HeatmapMode::kCenter;
+    } else if (heatmap_mode == "box") {
+      cfg.heatmap.mode = HeatmapMode::kBox;
+    } else {
+      std::cerr << "Unknown heatmap.mode: " << heatmap_mode
+                << " (anchor|center|box)\n";
+      std::exit(1);
+    }
+    cfg.heatmap.half_life_frames = frames_of(
+        tbl["heatmap"]["half_life_frames"].value<int64_t>(),
+        tbl["heatmap"]["half_life_ms"].value<int64_t>(), cfg.analytics.fps, 0,
+        "heatmap.half_life_frames / half_life_ms");
+    cfg.heatmap.export_dir = tbl["heatmap"]["export_dir"].value_or("");
+
+    cfg.proximity.distance = tbl["proximity"]["distance"].value_or(0.0f);
+    if (!(cfg.proximity.distance >= 0.0f)) {
+      std::cerr << "proximity.distance must be >= 0 (0 = off)\n";
+      std::exit(1);
+    }
+    if (const auto *proximity = tbl["proximity"].as_table())
+      cfg.proximity.classes = read_classes(*proximity, "proximity");
+    cfg.proximity.crowd_size = tbl["proximity"]["crowd_size"].value_or(3);
+    if (cfg.proximity.crowd_size < 2) {
+      std::cerr << "proximity.crowd_size must be >= 2\n";
+      std::exit(1);
+    }
+
+    cfg.affinity.receive_cpu = tbl["affinity"]["receive_cpu"].value_or(-1);
+    if (const auto *cpus = tbl["affinity"]["worker_cpus"].as_array()) {
+      for (const auto &cpu : *cpus) {
+        auto value = cpu.value<int>();
+        if (!value || *value < 0) {
+          std::cerr << "affinity.worker_cpus must be CPU numbers\n";
+          std::exit(1);
+        }
+        cfg.affinity.worker_cpus.push_back(*value);
+      }
+    }
+    cfg.affinity.busy_poll = tbl["affinity"]["busy_poll"].value_or(false);
+
+    if (const auto *zones = tbl["zones"].as_array()) {
+      for (const auto &node : *zones) {
+        const auto *zone = node.as_table();
+        if (zone == nullptr) {
+          std::cerr << "[[zones]] entries must be tables\n";
+          std::exit(1);
+        }
+        ZoneConfig z;
+        z.name = (*zone)["name"].value_or("zone" +
+                                          std::to_string(cfg.zones.size()));
+        z.source_id = (*zone)["source_id"].value_or(0);
+        if (const auto *points = (*zone)["points"].as_array()) {
+          for (const auto &point : *points) {
+            z.points.push_back(read_point(point, "zone " + z.name));
+          }
+        }
+        if (z.points.size() < 3) {
+          std::cerr << "zone " << z.name << ": needs at least 3 points\n";
+          std::exit(1);
+        }
+        z.classes = read_classes(*zone, "zone " + z.name);
+        z.loiter_frames = frames_of((*zone)["loiter_frames"].value<int64_t>(),
+                                    (*zone)["loiter_ms"].value<int64_t>(),
+                                    cfg.analytics.fps, 0,
+                                    "zone " + z.name + ": loiter");
+        cfg.zones.push_back(std::move(z));
+      }
+    }
+
+    if (const auto *wires = tbl["tripwires"].as_array()) {
+      for (const auto &node : *wires) {
+        const auto *wire = node.as_table();
+        if (wire == nullptr) {
+          std::cerr << "[[tripwires]] entries must be tables\n";
+          std::exit(1);
+        }
+        TripwireConfig w;
+        w.name = (*wire)["name"].value_or(
+            "line" + std::to_string(cfg.tripwires.size()));
+        w.source_id = (*wire)["source_id"].value_or(0);
+        const auto *from = (*wire)["from"].node();
+        const auto *to = (*wire)["to"].node();
+        if (from == nullptr || to == nullptr) {
+          std::cerr << "tripwire " << w.name << ": needs from and to\n";
+          std::exit(1);
+        }
+        w.from = read_point(*from, "tripwire " + w.name);
+        w.to = read_point(*to, "tripwire " + w.name);
+        if (w.from == w.to) {
+          std::cerr << "tripwire " << w.name << ": from and to are equal\n";
+          std::exit(1);
+        }
+        std::string direction = (*wire)["direction"].value_or("both");
+        if (direction == "both") {
+          w.direction = TripwireDirection::kBoth;
+        } else if (direction == "in") {
+          w.direction = TripwireDirection::kIn;
+        } else if (direction == "out") {
+          w.direction = TripwireDirection::kOut;
+        } else {
+          std::cerr << "tripwire " << w.name << ": unknown direction "
+                    << direction << " (both|in|out)\n";
+          std::exit(1);
+        }
+        w.classes = read_classes(*wire, "tripwire " + w.name);
+        cfg.tripwires.push_back(std::move(w));
+      }
+    }
+
+    if (const auto *rules = tbl["rules"].as_array()) {
+      for (const auto &node : *rules) {
+        const auto *rule = node.as_table();
+        if (rule == nullptr) {
+          std::cerr << "[[rules]] entries must be tables\n";
+          std::exit(1);
+        }
+        RuleConfig r;
+        r.name = (*rule)["name"].value_or(
+            "rule" + std::to_string(cfg.rules.size()));
+        auto source_id = (*rule)["source_id"].value<int>();
+        r.source_id = source_id.value_or(0);
+        r.all_sources = !source_id;
+        r.when = (*rule)["when"].value_or("");
+        if (r.when.empty()) {
+          std::cerr << "rule " << r.name << ": needs a when condition\n";
+          std::exit(1);
+        }
+        cfg.rules.push_back(std::move(r));
+      }
+    }
+
+    // Each source with zones, tripwires or rules needs a source slot.
+    auto slots = static_cast<size_t>(std::max(1, cfg.analytics.max_sources));
+    std::set<int> configured;
+    for (const auto &zone : cfg.zones)
+      configured.insert(zone.source_id);
+    for (const auto &wire : cfg.tripwires)
+      configured.insert(wire.source_id);
+    for (const auto &rule : cfg.rules) {
+      if (!rule.all_sources)
+        configured.insert(rule.source_id);
+    }
+    if (configured.size() > slots) {
+      std::cerr << "zones, tripwires and rules name " << configured.size()
+                << " sources, more than stream.max_sources (" << slots
+                << ")\n";
+      std::exit(1);
+    }
+
+    cfg.events.log = tbl["events"]["log"].value_or(false);
+    cfg.events.publish = tbl["events"]["publish"].value_or("");
+    std::string publish_format =
+        tbl["events"]["publish_format"].value_or("binary");
+    if (publish_format == "json") {
+      cfg.events.publish_format = WireFormat::kJson;
+    } else if (publish_format == "binary") {
+      cfg.events.publish_format = WireFormat::kBinary;
+    } else {
+      std::cerr << "Unknown events.publish_format: " << publish_format
+                << " (json|binary)\n";
+      std::exit(1);
+    }
+    cfg.events.publish_interval_ms =
+        tbl["events"]["publish_interval_ms"].value_or(0);
+    cfg.events.publish_queue = tbl["events"]["publish_queue"].value_or(4096);
+    cfg.events.publish_hwm = tbl["events"]["publish_hwm"].value_or(1000);
+    if (cfg.events.publish_interval_ms < 0 || cfg.events.publish_hwm < 0) {
+      std::cerr << "events.publish_interval_ms and publish_hwm must be >= 0\n";
+      std::exit(1);
+    }
+    if (cfg.events.publish_queue < 1) {
+      std::cerr << "events.publish_queue must be >= 1\n";
+      std::exit(1);
+    }
   } catch (const toml::parse_error &e) {
     std::cerr << "Failed to load config: " << path << "\n";
     std::cerr << e.description() << "\n";
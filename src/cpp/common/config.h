@@ -1,22 +1,180 @@
 #pragma once
 #include <string>
 #include <utility>
+#include <vector>
 
 struct AnalyticsConfig {
   int max_sources;
   int max_detections;
+  int report_interval_sec; // [stream] fps_check_interval_sec
+  int track_ttl_frames;    // [tracks] ttl_frames
+  int num_classes;         // [stream] num_classes; larger ids count as "other"
+  int fps;                 // [stream] fps; converts *_ms settings to frames
+  int track_expire_frames; // [tracks] expire_frames / expire_ms; 0 = never
+  int hll_precision;       // [uniques] precision; 2^p bytes per sketch
 };
 
+// Payload encoding on the wire; see analytics/wire_format.h for `kBinary`.
+enum class WireFormat { kJson, kBinary };
+
+// Consumer socket; the producer uses the matching PUB / PUSH.
+enum class SocketType { kSub, kPull };
+
 struct ZmqConfig {
-  std::string endpoint;
-  std::string socket_type;
+  std::string endpoint; // tcp:// or ipc://
+  SocketType socket_type;
+  bool bind;            // bind `endpoint` instead of connecting to it
   std::string subscribe;
   int rcvhwm;
+  WireFormat format;
+  int batch_size;           // max messages per receive batch (1 = no batching)
+  int batch_max_latency_us; // stop draining once the batch is this old
+};
+
+// inline:    one thread receives, decodes and runs analytics
+// pipelined: a receive thread feeds a decode/analytics thread through an
+//            SPSC ring of zmq messages
+// sharded:   a receive thread feeds `workers` decode/analytics threads,
+//            partitioned by source id (capped at max_sources)
+enum class PipelineMode { kInline, kPipelined, kSharded };
+
+struct PipelineConfig {
+  PipelineMode mode;
+  int workers;         // sharded mode only
+  int ring_capacity;   // messages per worker; rounded up to a power of two
+  int spin_iterations; // busy-spins on an empty/full ring before backing off
+};
+
+// What to do with frames that pile up while the consumer is behind; see
+// analytics/overload.h.
+enum class OverloadPolicy { kQueue, kConflatePerSource, kDropOldest };
+
+struct OverloadConfig {
+  OverloadPolicy policy;
+  int max_pending; // drop-oldest: newest frames kept per drain
+};
+
+// Record the received stream to a file, or replay one instead of receiving;
+// see analytics/capture.h.
+enum class CaptureMode { kOff, kRecord, kReplay };
+
+struct CaptureConfig {
+  CaptureMode mode;
+  std::string path;
+  int max_mb;   // record: size the capture file is mapped at
+  double speed; // replay: 0 = as fast as possible, 1 = original timing
+};
+
+// CPU pinning; see analytics/affinity.h. -1 / empty = scheduler decides.
+struct AffinityConfig {
+  int receive_cpu;              // receive thread (everything in inline mode)
+  std::vector<int> worker_cpus; // worker i runs on worker_cpus[i % size]
+  bool busy_poll;               // receive + worker threads spin, never sleep
+};
+
+// One `[[zones]]` entry: a polygon region of interest on one source; see
+// analytics/zones.h.
+struct ZoneConfig {
+  std::string name;
+  int source_id;
+  std::vector<std::pair<float, float>> points; // (x, y), >= 3, in order
+  std::vector<int> classes;                    // counted classes; empty = all
+  int loiter_frames;                           // loitering alert after; 0 = off
+};
+
+enum class TripwireDirection { kBoth, kIn, kOut };
+
+// One `[[tripwires]]` entry: a counting line on one source; see
+// analytics/tripwires.h. `in` crosses from the left of from -> to (as drawn
+// on the image) to its right.
+struct TripwireConfig {
+  std::string name;
+  int source_id;
+  std::pair<float, float> from; // (x, y)
+  std::pair<float, float> to;
+  TripwireDirection direction; // crossings counted
+  std::vector<int> classes;    // counted classes; empty = all
+};
+
+// One `[[rules]]` entry: a condition over each detection (and its track),
+// compiled at startup; see analytics/rules.h for the language.
+struct RuleConfig {
+  std::string name;
+  int source_id;    // zone names refer to this source
+  bool all_sources; // no source_id: every source, and no zones
+  std::string when;
+};
+
+// Per-track alpha-beta motion filter; see analytics/track_table.h.
+struct MotionConfig {
+  bool enabled;
+  float alpha; // position gain, (0, 1]
+  float beta;  // velocity gain, [0, 4 - 2 alpha)
+};
+
+// Detections dropped while decoding; see analytics/detection_filter.h.
+struct FilterConfig {
+  std::vector<int> classes; // classes kept, ids < 256; empty = all
+  float min_confidence;     // detections below are dropped; 0 = off
+};
+
+// Sliding-window aggregates; see analytics/windows.h.
+struct WindowConfig {
+  int bucket_sec;             // resolution; buckets close on a timer
+  std::vector<int> spans_sec; // window lengths; empty = off
+};
+
+// What a detection adds to the heatmap: one cell under its bbox bottom-centre
+// or centre, or every cell its bbox overlaps.
+enum class HeatmapMode { kAnchor, kCenter, kBox };
+
+// Per-source occupancy heatmaps; see analytics/heatmap.h.
+struct HeatmapConfig {
+  int cols; // grid cells across; 0 = off
+  int rows;
+  float frame_width; // image size bboxes are given in
+  float frame_height;
+  HeatmapMode mode;
+  int half_life_frames;   // exponential decay; 0 = accumulate forever
+  std::string export_dir; // raw snapshots written here each report; "" = off
+};
+
+// Per-frame proximity pairs and crowds; see analytics/proximity.h.
+struct ProximityConfig {
+  float distance;           // pixels between bbox bottom-centres; 0 = off
+  std::vector<int> classes; // classes considered; empty = all
+  int crowd_size;           // detections chained by close pairs for a crowd
+};
+
+// Analytics events (line crossings, ...); see analytics/events.h and, for
+// publishing them, analytics/publisher.h.
+struct EventConfig {
+  bool log;                   // print every event to stderr
+  std::string publish;        // PUB endpoint to bind; empty = off
+  WireFormat publish_format;  // encoding of published messages
+  int publish_interval_ms;    // coalescing window; 0 = one per payload
+  int publish_queue;          // records queued per consumer thread
+  int publish_hwm;            // PUB send high-water mark (messages)
 };
 
 struct Config {
   AnalyticsConfig analytics;
   ZmqConfig zmq;
+  PipelineConfig pipeline;
+  OverloadConfig overload;
+  CaptureConfig capture;
+  AffinityConfig affinity;
+  FilterConfig filter;
+  std::vector<ZoneConfig> zones;
+  std::vector<TripwireConfig> tripwires;
+  MotionConfig motion;
+  std::vector<RuleConfig> rules;
+  WindowConfig windows;
+  HeatmapConfig heatmap;
+  ProximityConfig proximity;
+  EventConfig events;
 };
 
+// Reads `path`, or only the defaults if it is empty. Prints the problem and
+// exits on a bad file or value.
 Config load_config(const std::string &path);
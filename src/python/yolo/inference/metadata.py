@@ -5,6 +5,7 @@ from __future__ import annotations
 import json
 import logging
 import random
+import struct
 import time
 from typing import TYPE_CHECKING
 from typing import Any
@@ -18,6 +19,14 @@ logger = logging.getLogger(__name__)
 
 # ruff: noqa: S311 - Allow use of random for simulation purposes
 
+# Binary wire format v1; mirrors src/cpp/analytics/wire_format.h.
+# Header: magic, version, header_size, source_id, frame_num, count, uri_len
+WIRE_MAGIC = b"YDET"
+WIRE_VERSION = 1
+WIRE_HEADER = struct.Struct("<4sHHiiII")
+# Detection: track_id, class_id, confidence, left, top, width, height
+WIRE_DETECTION = struct.Struct("<iifffff")
+
 
 def rect_params_to_dict(left: float, top: float, width: float, height: float) -> dict:
     """Convert rectangle parameters to JSON serializable dict."""
@@ -53,14 +62,69 @@ def format_obj_meta(  # noqa: PLR0913 - Mimicking DeepStream API structure
     }
 
 
-def send_metadata(
+def encode_binary_frame(
+    source_id: int,
+    frame_num: int,
+    uri: str,
+    frame_objects: list[dict[str, Any]],
+) -> bytes:
+    """Encode one frame in the fixed-layout binary wire format.
+
+    The uri is written once per frame instead of once per detection, and
+    detections are packed as little-endian int/float records the C++
+    consumer reads in place.
+    """
+    uri_bytes = uri.encode("utf-8")
+    padding = b"\0" * (-len(uri_bytes) % 4)
+    header = WIRE_HEADER.pack(
+        WIRE_MAGIC,
+        WIRE_VERSION,
+        WIRE_HEADER.size,
+        source_id,
+        frame_num,
+        len(frame_objects),
+        len(uri_bytes),
+    )
+    detections = [
+        WIRE_DETECTION.pack(
+            obj["track_id"],
+            obj["class_id"],
+            obj["confidence"],
+            obj["bbox"]["left"],
+            obj["bbox"]["top"],
+            obj["bbox"]["width"],
+            obj["bbox"]["height"],
+        )
+        for obj in frame_objects
+    ]
+    return b"".join([header, uri_bytes, padding, *detections])
+
+
+def send_metadata(  # noqa: PLR0913 - frame_num/uri only used by binary format
     socket: zmq.Socket,
     source_id: int,
     frame_objects: list[dict[str, Any]],
+    *,
+    wire_format: str = "json",
+    frame_num: int = 0,
+    uri: str = "",
 ) -> None:
-    """Send metadata via ZeroMQ (PUB socket)."""
-    metadata = {source_id: frame_objects}
-    socket.send_multipart([b"inference", json.dumps(metadata).encode("utf-8")])
+    """Send metadata via ZeroMQ (PUB or PUSH socket).
+
+    Args:
+        socket: ZeroMQ socket to send on
+        source_id: Source (camera) identifier
+        frame_objects: Detections for this frame
+        wire_format: "json" or "binary" (see `encode_binary_frame`)
+        frame_num: Frame number, used by the binary header
+        uri: Stream uri, used by the binary header
+    """
+    if wire_format == "binary":
+        payload = encode_binary_frame(source_id, frame_num, uri, frame_objects)
+    else:
+        metadata = {source_id: frame_objects}
+        payload = json.dumps(metadata).encode("utf-8")
+    socket.send_multipart([b"inference", payload])
 
 
 def live_stream_tracker_simulation(
@@ -139,6 +203,39 @@ def live_stream_tracker_simulation(
         }
 
 
+def open_producer_socket(
+    context: zmq.Context, zmq_config: dict[str, Any]
+) -> tuple[zmq.Socket, str]:
+    """Open the producer socket matching the consumer's `[zmq]` settings.
+
+    A `sub` consumer gets a PUB producer, a `pull` consumer gets a PUSH
+    producer (load-balanced across consumers). The producer binds unless the
+    consumer does (`bind = true`), in which case it connects to `endpoint`.
+    When binding, `producer_endpoint` wins; otherwise TCP binds on all
+    interfaces at `port` and ipc:// binds the shared `endpoint`. inproc://
+    cannot reach the consumer, which is a separate process.
+
+    Returns:
+        The socket and the endpoint it was bound or connected to.
+    """
+    endpoint = zmq_config.get("endpoint", "tcp://127.0.0.1:5555")
+    socket_type = zmq.PUSH if zmq_config.get("socket_type") == "pull" else zmq.PUB
+    socket = context.socket(socket_type)
+
+    if zmq_config.get("bind", False):
+        socket.connect(endpoint)
+        return socket, endpoint
+
+    bind_endpoint = zmq_config.get("producer_endpoint")
+    if bind_endpoint is None:
+        if endpoint.startswith("tcp://"):
+            bind_endpoint = f"tcp://*:{zmq_config.get('port', 5555)}"
+        else:
+            bind_endpoint = endpoint
+    socket.bind(bind_endpoint)
+    return socket, bind_endpoint
+
+
 def run_simulation(
     config_data: dict[str, Any],
 ) -> None:
@@ -147,7 +244,7 @@ def run_simulation(
     fps = config_data["stream"]["fps"]
     source_id = config_data["stream"].get("source_id", 0)
     uri = config_data["stream"].get("uri", "rtsp://camera/stream")
-    port = config_data["zmq"].get("port", 5555)
+    wire_format = config_data["zmq"].get("format", "json")
     fps_check_interval_sec = config_data["stream"].get("fps_interval_sec", 10)
     new_object_probability = config_data["simulation"].get(
         "new_object_probability", 0.1
@@ -156,13 +253,12 @@ def run_simulation(
         "object_exit_probability", 0.05
     )
 
-    # Initialize ZeroMQ PUB socket
+    # Initialize ZeroMQ PUB / PUSH socket
     context = zmq.Context()
-    socket = context.socket(zmq.PUB)
-    socket.bind(f"tcp://*:{port}")
+    socket, endpoint = open_producer_socket(context, config_data["zmq"])
 
     logger.info("📡 Sending Live Stream Metadata via ZeroMQ (Ctrl+C to stop)...")
-    logger.info("📡 Publishing on tcp://*:%s", port)
+    logger.info("📡 Publishing on %s (%s)", endpoint, wire_format)
 
     # FPS tracking
     interval_start_time = time.time()
@@ -180,6 +276,9 @@ def run_simulation(
                 socket=socket,
                 source_id=source_id,
                 frame_objects=metadata["detections"],
+                wire_format=wire_format,
+                frame_num=metadata["frame_num"],
+                uri=uri,
             )
 
             # Track FPS